@@ -16,6 +16,24 @@
 #include <chrono>
 #include <thread>
 #include <optional>
+#include <vector>
+#include <numeric>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <signal.h>
+#include <cerrno>
+#include <memory>
+#include <condition_variable>
+#include <cstring>
 
 using namespace std;
 
@@ -31,6 +49,8 @@ public:
     unordered_set<string> propertiesOwned; // Set of property names owned by the player
     unordered_map<string, int> propertyUpgrades; // Tracks upgrades (houses/hotels) on properties owned by the player
     bool isAI; // Flag to indicate if the player is an AI
+    int seat = 0; // Seat number (0-based) assigned when the player joins the game
+    int controlledAction = -1; // Action bits set by an external controller such as the training environment (-1 lets the AI decide)
 
     // Constructor to initialize player details
     Player(string name, int money = 1500, int position = 0, bool isAI = false)
@@ -47,6 +67,256 @@ struct Bid {
     }
 };
 
+// Fixed-size, lock-free cache of AI decisions shared by every board and worker thread.
+// Each entry is a single 64-bit word holding the upper key bits, a valid bit, a cost and the value,
+// so readers never see a torn entry and no locks are needed. Slots are grouped into two-way buckets with
+// two-tier replacement: the first slot keeps the most expensive entry seen (by the caller's cost) and the
+// second takes every other new entry, so costly answers survive while new ones still get cached.
+class DecisionCache {
+public:
+    // Counters reported by stats()
+    struct Stats {
+        uint64_t hits = 0; // Lookups that found their key
+        uint64_t misses = 0; // Lookups that did not find their key
+        uint64_t collisions = 0; // Misses where the bucket was full of other keys
+        uint64_t stores = 0; // Entries written
+        uint64_t evictions = 0; // Stores that replaced a different key
+    };
+
+    static constexpr int minSizeLog2 = 1; // Smallest table: one two-way bucket
+    static constexpr int maxSizeLog2 = 24; // Largest table the key tag layout allows
+
+    // Create a cache with 2^sizeLog2 slots, clamping sizeLog2 to [minSizeLog2, maxSizeLog2]
+    explicit DecisionCache(int sizeLog2 = 20)
+        : mask((size_t(1) << clampSizeLog2(sizeLog2)) - 1), slots(size_t(1) << clampSizeLog2(sizeLog2)) {
+        for (auto& slot : slots) {
+            slot.store(0, memory_order_relaxed);
+        }
+    }
+
+    // Look up a key, storing its value if it is present
+    bool lookup(uint64_t key, int& value) {
+        size_t bucket = key & mask & ~size_t(1);
+        uint64_t tag = key & tagMask;
+        bool bucketFull = true;
+        for (size_t i = bucket; i < bucket + 2; ++i) {
+            uint64_t entry = slots[i].load(memory_order_relaxed);
+            if ((entry & (tagMask | validBit)) == (tag | validBit)) {
+                value = static_cast<int16_t>(entry & 0xffff);
+                count(&Stripe::hits);
+                return true;
+            }
+            bucketFull = bucketFull && (entry & validBit);
+        }
+        count(&Stripe::misses);
+        if (bucketFull) {
+            count(&Stripe::collisions);
+        }
+        return false;
+    }
+
+    // Store a value for a key; cost ranks how expensive the value was to compute (0-255) for replacement
+    void store(uint64_t key, int value, int cost = 0) {
+        size_t bucket = key & mask & ~size_t(1);
+        uint64_t tag = key & tagMask;
+        uint64_t entry = tag | validBit | (uint64_t(cost & 0xff) << 16) | uint16_t(value);
+        uint64_t first = slots[bucket].load(memory_order_relaxed);
+        uint64_t second = slots[bucket + 1].load(memory_order_relaxed);
+        auto holdsKey = [tag](uint64_t current) { return (current & (tagMask | validBit)) == (tag | validBit); };
+        auto costOf = [](uint64_t current) { return static_cast<int>((current >> 16) & 0xff); };
+
+        uint64_t evicted = 0;
+        if (holdsKey(first) || !(first & validBit)) {
+            slots[bucket].store(entry, memory_order_relaxed);
+        } else if (holdsKey(second) || !(second & validBit)) {
+            slots[bucket + 1].store(entry, memory_order_relaxed);
+        } else if ((cost & 0xff) >= costOf(first)) {
+            // The new entry takes the first slot and the previous occupant moves down to the second
+            slots[bucket].store(entry, memory_order_relaxed);
+            slots[bucket + 1].store(first, memory_order_relaxed);
+            evicted = second;
+        } else {
+            slots[bucket + 1].store(entry, memory_order_relaxed);
+            evicted = second;
+        }
+        count(&Stripe::stores);
+        if (evicted & validBit) {
+            count(&Stripe::evictions);
+        }
+    }
+
+    // Sum the counters across all stripes
+    Stats stats() const {
+        Stats total;
+        for (const auto& stripe : stripes) {
+            total.hits += stripe.hits.load(memory_order_relaxed);
+            total.misses += stripe.misses.load(memory_order_relaxed);
+            total.collisions += stripe.collisions.load(memory_order_relaxed);
+            total.stores += stripe.stores.load(memory_order_relaxed);
+            total.evictions += stripe.evictions.load(memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    // Keep a requested table size within the supported range
+    static int clampSizeLog2(int sizeLog2) {
+        return max(minSizeLog2, min(maxSizeLog2, sizeLog2));
+    }
+
+    static constexpr uint64_t tagMask = ~uint64_t(0) << 25; // Upper key bits kept to recognise entries
+    static constexpr uint64_t validBit = uint64_t(1) << 24; // Set on every stored entry
+
+    // Counters are striped across cache lines by thread so they never become a contention point
+    struct alignas(64) Stripe {
+        atomic<uint64_t> hits{0};
+        atomic<uint64_t> misses{0};
+        atomic<uint64_t> collisions{0};
+        atomic<uint64_t> stores{0};
+        atomic<uint64_t> evictions{0};
+    };
+
+    // Bump a counter in the calling thread's stripe
+    void count(atomic<uint64_t> Stripe::*counter) {
+        static thread_local size_t stripe = std::hash<thread::id>()(this_thread::get_id()) % numStripes;
+        (stripes[stripe].*counter).fetch_add(1, memory_order_relaxed);
+    }
+
+    static const size_t numStripes = 16;
+    size_t mask;
+    vector<atomic<uint64_t>> slots;
+    Stripe stripes[numStripes];
+};
+
+// One game event as published to spectators (16 bytes)
+struct GameEvent {
+    enum Type : uint8_t {
+        TurnStart, // A player's turn begins
+        Move, // A player rolled amount and moved to position
+        Purchase, // A player bought the property at position for amount
+        Rent, // A player paid amount in rent to otherSeat
+        Tax, // A player paid amount in tax
+        Card, // A community chest card changed a player's money by amount
+        GoToJail, // A player was sent to jail
+        LeaveJail, // A player left jail
+        AuctionWon, // A player won the auction for position with a bid of amount
+        Upgrade, // A player upgraded the property at position
+        Mortgage, // A player mortgaged the property at position
+        Bankrupt, // A player went bankrupt owing amount (negative), which the bank absorbs
+        GameOver, // A player won the game
+        Salary // A player collected amount for landing on Go
+    };
+
+    uint32_t turn; // Turn number the event happened in
+    uint8_t type; // One of Type
+    uint8_t seat; // Seat of the player the event is about
+    uint8_t otherSeat; // Seat of the other player involved (255 for none)
+    uint8_t position; // Board position involved
+    int32_t amount; // Money or dice amount involved
+    int32_t money; // The player's money after the event
+};
+static_assert(sizeof(GameEvent) == 16, "GameEvent must fit in two 64-bit ring words");
+
+// Lock-free single-producer, multi-consumer ring of game events. The game publishes each event once and
+// never waits; every consumer keeps its own read position. Each slot carries a version number (odd while
+// being written) so readers can tell a published event from a slot that is still empty or has already
+// been overwritten by a newer lap of the ring.
+class EventRing {
+public:
+    // Result of reading one event
+    enum class ReadResult { Ok, Empty, Overrun };
+
+    // Create a ring holding the most recent 2^sizeLog2 events
+    explicit EventRing(int sizeLog2 = 16) : mask((size_t(1) << sizeLog2) - 1), slots(size_t(1) << sizeLog2) {}
+
+    // Publish an event (producer thread only)
+    void publish(const GameEvent& event) {
+        uint64_t sequence = head.load(memory_order_relaxed);
+        Slot& slot = slots[sequence & mask];
+        uint64_t words[2];
+        memcpy(words, &event, sizeof(words));
+
+        slot.version.store(2 * sequence + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        slot.words[0].store(words[0], memory_order_relaxed);
+        slot.words[1].store(words[1], memory_order_relaxed);
+        slot.version.store(2 * sequence + 2, memory_order_release);
+        head.store(sequence + 1, memory_order_release);
+    }
+
+    // Read the event with the given sequence number (any thread)
+    ReadResult read(uint64_t sequence, GameEvent& event) const {
+        const Slot& slot = slots[sequence & mask];
+        uint64_t expected = 2 * sequence + 2;
+        uint64_t before = slot.version.load(memory_order_acquire);
+        if (before < expected) {
+            return ReadResult::Empty; // Not published yet
+        }
+        if (before > expected) {
+            return ReadResult::Overrun;
+        }
+        uint64_t words[2] = {slot.words[0].load(memory_order_relaxed), slot.words[1].load(memory_order_relaxed)};
+        atomic_thread_fence(memory_order_acquire);
+        if (slot.version.load(memory_order_relaxed) != expected) {
+            return ReadResult::Overrun; // Overwritten while reading
+        }
+        memcpy(&event, words, sizeof(words));
+        return ReadResult::Ok;
+    }
+
+    // Sequence number the next published event will get
+    uint64_t published() const {
+        return head.load(memory_order_acquire);
+    }
+
+    // Number of events the ring holds
+    uint64_t capacity() const {
+        return mask + 1;
+    }
+
+private:
+    // A 32-byte slot: version plus the event stored as two words
+    struct Slot {
+        atomic<uint64_t> version{0};
+        atomic<uint64_t> words[2] = {{0}, {0}};
+        uint64_t padding = 0;
+    };
+
+    size_t mask;
+    vector<Slot> slots;
+    alignas(64) atomic<uint64_t> head{0}; // Written only by the producer
+};
+
+// A consumer's read position in an event ring; slow consumers skip ahead and count what they missed
+class EventSubscriber {
+public:
+    explicit EventSubscriber(const EventRing& ring) : ring(ring), next(ring.published()) {}
+
+    // Fetch the next event, returning false when the consumer has caught up with the game
+    bool poll(GameEvent& event) {
+        while (true) {
+            EventRing::ReadResult result = ring.read(next, event);
+            if (result == EventRing::ReadResult::Ok) {
+                next++;
+                return true;
+            }
+            if (result == EventRing::ReadResult::Empty) {
+                return false;
+            }
+            // Overrun: skip ahead to the oldest event the producer is not about to overwrite
+            uint64_t oldest = ring.published() - ring.capacity() + 1;
+            missed += oldest - next;
+            next = oldest;
+        }
+    }
+
+    uint64_t missed = 0; // Events overwritten before this consumer could read them
+
+private:
+    const EventRing& ring;
+    uint64_t next; // Sequence number of the next event to read
+};
+
 // Board class to manage game operations
 class Board {
 public:
@@ -62,11 +332,34 @@ public:
     unordered_map<int, string> specialSpaces; // Maps board positions to special spaces (e.g., Go, Jail)
     const int upgradeCost = 100; // Cost to upgrade a property
     const int rentMultiplier = 2; // Rent multiplier per upgrade level
-    std::random_device rd; // Random device for random number generation
+    const double winProbabilityExponent = 3.0; // Sharpness of the win probability estimate across players' equity
+    const double aiRiskTolerance = 0.1; // Highest chance of going bankrupt the valuation AI accepts when spending
+    const int ruinHorizon = 50; // Rounds the valuation AI looks ahead
     std::mt19937 rng; // Mersenne Twister random number generator
-
-    // Constructor to initialize the board and game elements
-    Board() : rng(rd()) {
+    mutable ostream out; // Stream for game messages (silenced for simulations)
+    long long bankFlow = 0; // Net money the bank has paid out to players, including starting money
+    const vector<int>* decisionScript = nullptr; // Scripted AI decisions for fuzzing and replays (nullptr draws from rng)
+    size_t decisionIndex = 0; // Next entry of the decision script to use
+    size_t turnCursor = 0; // Seat of the player whose turn is next in simulations
+    int turnCount = 0; // Number of turns played through playNextTurn
+    int ownershipChanges = 0; // Number of times a property changed owner or mortgage state
+
+    // How AI players decide whether to buy a property or bid in an auction
+    enum class AIPolicy {
+        Random, // Coin flip (or the decision script)
+        Valuation // Spend only while the estimated risk of going bankrupt stays low
+    };
+    AIPolicy aiPolicy = AIPolicy::Random; // Policy used by every AI player on this board
+    DecisionCache* decisionCache = nullptr; // Optional cache of valuation decisions, shared across boards
+    static const int buyAction = 1; // Action bit: buy an unowned property the player lands on
+    static const int bidAction = 2; // Action bit: bid the starting price in auctions
+    EventRing* eventRing = nullptr; // Optional ring that every game event is published to for spectators
+
+    // Constructor to initialize the board with a random seed
+    Board() : Board(std::random_device{}()) {}
+
+    // Constructor to initialize the board and game elements from a fixed seed
+    explicit Board(unsigned int seed, bool verbose = true) : rng(seed), out(verbose ? cout.rdbuf() : nullptr) {
         // Initialize properties with their positions and names
         properties = {
             {1, "Mediterranean Avenue"}, {3, "Baltic Avenue"},
@@ -88,6 +381,25 @@ public:
             rentPrices[property.second] = 50; // Simplified rent price for all properties
         }
 
+        // Deal the shuffled card decks
+        dealDecks();
+
+        // Initialize special spaces on the board (e.g., Go, Jail, etc.)
+        specialSpaces = {
+            {0, "Go"},
+            {4, "Income Tax"},
+            {10, "Jail"},
+            {20, "Free Parking"},
+            {30, "Go to Jail"},
+            {38, "Luxury Tax"}
+        };
+    }
+
+    // Fill both card decks with freshly shuffled cards, discarding any cards left
+    void dealDecks() {
+        communityChest = stack<string>();
+        chance = queue<string>();
+
         // Initialize community chest cards
         list<string> communityChestCards = {
             "Bank error in your favor. Collect $200.",
@@ -137,16 +449,22 @@ public:
         for (const auto& card : chanceCards) {
             chance.push(card);
         }
+    }
 
-        // Initialize special spaces on the board (e.g., Go, Jail, etc.)
-        specialSpaces = {
-            {0, "Go"},
-            {4, "Income Tax"},
-            {10, "Jail"},
-            {20, "Free Parking"},
-            {30, "Go to Jail"},
-            {38, "Luxury Tax"}
-        };
+    // Start a new game on this board from a fixed seed without reallocating it: players, ownership, decks,
+    // the random generator and the bookkeeping counters return to their freshly constructed state
+    void reset(unsigned int seed) {
+        rng.seed(seed);
+        players.clear();
+        ownedProperties.clear();
+        propertyOwners.clear();
+        mortgagedProperties.clear();
+        bankFlow = 0;
+        decisionIndex = 0;
+        turnCursor = 0;
+        turnCount = 0;
+        ownershipChanges = 0;
+        dealDecks();
     }
 
     // Function to shuffle a list
@@ -174,6 +492,52 @@ public:
     // Add a player to the game by creating a Player object and adding it to the list of players
     void addPlayer(const string& playerName, bool isAI = false) {
         players.emplace_back(playerName, 1500, 0, isAI);
+        players.back().seat = static_cast<int>(players.size()) - 1;
+        bankFlow += 1500; // Starting money comes from the bank
+    }
+
+    // Board position of a property
+    int positionOf(const string& propertyName) const {
+        auto propertyIt = std::find_if(properties.begin(), properties.end(),
+            [&propertyName](const pair<const int, string>& property) { return property.second == propertyName; });
+        return propertyIt != properties.end() ? propertyIt->first : 0;
+    }
+
+    // Publish an event to the spectator ring, if one is attached
+    void publishEvent(GameEvent::Type type, const Player& player, int position, int amount = 0, int otherSeat = 255) {
+        if (!eventRing) return;
+        eventRing->publish({static_cast<uint32_t>(turnCount), type, static_cast<uint8_t>(player.seat),
+                            static_cast<uint8_t>(otherSeat), static_cast<uint8_t>(position), amount, player.money});
+    }
+
+    // Play the next player's turn in seating order without any prompts (used by simulations)
+    // Returns false once the game is over
+    bool playNextTurn() {
+        if (players.size() <= 1) {
+            return false;
+        }
+        if (turnCursor >= players.size()) {
+            turnCursor = 0;
+        }
+        auto playerIt = players.begin();
+        advance(playerIt, turnCursor);
+        playTurn(*playerIt);
+        turnCount++;
+
+        // Players removed at or before the current seat shift the next seat down
+        size_t removedUpToCursor = 0;
+        auto it = players.begin();
+        for (size_t seat = 0; seat <= turnCursor; ++seat, ++it) {
+            if (it->bankrupt) {
+                removedUpToCursor++;
+            }
+        }
+        removeBankruptPlayers();
+        turnCursor = turnCursor + 1 - removedUpToCursor;
+        if (players.size() == 1) {
+            publishEvent(GameEvent::GameOver, players.front(), players.front().position);
+        }
+        return players.size() > 1;
     }
 
     // Function to simulate a player's turn
@@ -182,6 +546,7 @@ public:
         if (player.bankrupt) {
             return;
         }
+        publishEvent(GameEvent::TurnStart, player, player.position);
 
         // If player is in jail, handle their jail turn
         if (player.inJail) {
@@ -193,6 +558,7 @@ public:
         std::uniform_int_distribution<int> dist(1, 6);
         int roll = dist(rng);
         player.position = (player.position + roll) % 40; // Update player position, board has 40 spaces
+        publishEvent(GameEvent::Move, player, player.position, roll);
 
         // Display board visualization
         displayBoard();
@@ -207,8 +573,8 @@ public:
         // Handle properties landing
         auto propertyIt = properties.find(player.position);
         if (propertyIt != properties.end()) {
-            string propertyName = propertyIt->second;
-            cout << player.name << " rolled a " << roll << " and landed on " << propertyName << endl;
+            const string& propertyName = propertyIt->second;
+            out << player.name << " rolled a " << roll << " and landed on " << propertyName << endl;
 
             // If property is not owned by any player
             if (ownedProperties.find(propertyName) == ownedProperties.end()) {
@@ -216,27 +582,33 @@ public:
                     // AI Decision to buy property
                     if (shouldAIBuyProperty(player, propertyName)) {
                         player.money -= 100;
+                        bankFlow -= 100;
                         ownedProperties.insert(propertyName);
                         propertyOwners[propertyName] = player.name;
+                        ownershipChanges++;
                         player.propertiesOwned.insert(propertyName);
                         player.propertyUpgrades[propertyName] = 0;
-                        cout << player.name << " (AI) bought " << propertyName << endl;
+                        publishEvent(GameEvent::Purchase, player, player.position, 100);
+                        out << player.name << " (AI) bought " << propertyName << endl;
                     } else {
-                        cout << player.name << " (AI) decided not to buy " << propertyName << "." << endl;
+                        out << player.name << " (AI) decided not to buy " << propertyName << "." << endl;
                     }
                 } else {
                     // Offer to buy the property for human players
-                    cout << propertyName << " is available for purchase." << endl;
+                    out << propertyName << " is available for purchase." << endl;
                     char choice;
-                    cout << "Do you want to buy it? (y/n): ";
+                    out << "Do you want to buy it? (y/n): ";
                     cin >> choice;
                     if (choice == 'y') {
                         player.money -= 100; // Assume all properties cost $100 for simplicity
+                        bankFlow -= 100;
                         ownedProperties.insert(propertyName);
                         propertyOwners[propertyName] = player.name;
+                        ownershipChanges++;
                         player.propertiesOwned.insert(propertyName);
                         player.propertyUpgrades[propertyName] = 0; // No upgrades initially
-                        cout << player.name << " bought " << propertyName << endl;
+                        publishEvent(GameEvent::Purchase, player, player.position, 100);
+                        out << player.name << " bought " << propertyName << endl;
                     } else {
                         // Start auction if player does not want to buy
                         auctionProperty(propertyName);
@@ -247,31 +619,37 @@ public:
                 if (propertyOwners[propertyName] != player.name) {
                     // If the property is not mortgaged, pay rent
                     if (!mortgagedProperties[propertyName]) {
-                        int rent = rentPrices[propertyName] * (1 + player.propertyUpgrades[propertyName] * rentMultiplier);
-                        cout << propertyName << " is owned by " << propertyOwners[propertyName] << ". You must pay rent of $" << rent << "." << endl;
+                        // Rent grows with the upgrades the owner has built on the property
+                        auto ownerPlayer = findPlayer(propertyOwners[propertyName]);
+                        int upgrades = ownerPlayer ? ownerPlayer.value().get().propertyUpgrades[propertyName] : 0;
+                        int rent = rentPrices[propertyName] * (1 + upgrades * rentMultiplier);
+                        out << propertyName << " is owned by " << propertyOwners[propertyName] << ". You must pay rent of $" << rent << "." << endl;
                         player.money -= rent;
                         if (player.money < 0) {
+                            bankFlow -= rent; // Rent is forfeited to the bank when the payer goes bankrupt
                             handleBankruptcy(player);
                             return;
                         }
                         // Pay rent to the property owner
-                        auto ownerPlayer = findPlayer(propertyOwners[propertyName]);
                         if (ownerPlayer) {
                             ownerPlayer.value().get().money += rent;
+                        } else {
+                            bankFlow -= rent;
                         }
-                        cout << player.name << " paid $" << rent << " in rent to " << propertyOwners[propertyName] << endl;
+                        publishEvent(GameEvent::Rent, player, player.position, rent, ownerPlayer ? ownerPlayer.value().get().seat : 255);
+                        out << player.name << " paid $" << rent << " in rent to " << propertyOwners[propertyName] << endl;
                     } else {
                         // Property is mortgaged, no rent is paid
-                        cout << propertyName << " is mortgaged. No rent is due." << endl;
+                        out << propertyName << " is mortgaged. No rent is due." << endl;
                     }
                 } else {
                     // Player landed on their own property
-                    cout << propertyName << " is already owned by you." << endl;
+                    out << propertyName << " is already owned by you." << endl;
                 }
             }
         } else {
             // Player landed on an empty space (not a property or special space)
-            cout << player.name << " rolled a " << roll << " and landed on an empty space." << endl;
+            out << player.name << " rolled a " << roll << " and landed on an empty space." << endl;
         }
 
         // Random chance to draw a community chest card (1 in 5 chance)
@@ -287,17 +665,106 @@ public:
 
     // Smarter AI decision-making to decide whether to buy a property
     bool shouldAIBuyProperty(const Player& player, const string& propertyName) {
+        if (player.controlledAction >= 0) {
+            return (player.controlledAction & buyAction) && player.money >= 100; // Externally controlled player
+        }
         if (player.money < 150) {
             return false; // AI won't buy if low on money
         }
         if (propertyName == "Boardwalk" || propertyName == "Park Place") {
             return true; // AI always buys premium properties
         }
-        return (rand() % 2 == 0); // Random decision for other properties
+        if (aiPolicy == AIPolicy::Valuation) {
+            return valuationDecision(player, 100);
+        }
+        return aiDecision(); // Random decision for other properties
+    }
+
+    // Valuation AI policy: decide whether the player can afford to spend the given price
+    // The decision only depends on the cache key's fields, so cached and fresh answers always agree
+    bool valuationDecision(const Player& player, int price) {
+        // Unaffordable prices are declined before consulting the cache, since their cash band would
+        // collide with prices that leave less than one band of cash
+        if (player.money < price) {
+            return false;
+        }
+        const int rent = 50; // Base rent of every property, also the size of a cash band
+        int cashBand = (player.money - price) / rent;
+        int ownHoldings = static_cast<int>(player.propertiesOwned.size());
+        int opponentHoldings = static_cast<int>(ownedProperties.size()) - ownHoldings;
+        int opponents = -1;
+        for (const auto& other : players) {
+            if (!other.bankrupt) opponents++;
+        }
+        return valuationDecision(cashBand, ownHoldings, opponentHoldings, opponents);
+    }
+
+    // Valuation AI policy for a decision-relevant state, answered from the decision cache when possible
+    bool valuationDecision(int cashBand, int ownHoldings, int opponentHoldings, int opponents) {
+        // Pack the decision-relevant state and mix it into a well-spread 64-bit key
+        uint64_t key = (uint64_t(cashBand) << 16) | (uint64_t(ownHoldings) << 8) | (uint64_t(opponentHoldings) << 3) | uint64_t(opponents & 7);
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+        key ^= key >> 31;
+
+        int cached = 0;
+        if (decisionCache && decisionCache->lookup(key, cached)) {
+            return cached != 0;
+        }
+        bool decision = ruinProbability(cashBand, ownHoldings, opponentHoldings, opponents) < aiRiskTolerance;
+        if (decisionCache) {
+            // The cost of the answer is the work ruinProbability did, scaled to the cache's 0-255 range
+            int work = (cashBand + ruinHorizon + 1) * ruinHorizon;
+            decisionCache->store(key, decision, min(255, work / 64));
+        }
+        return decision;
+    }
+
+    // Probability that a player with the given number of $50 cash bands goes bankrupt within the next rounds
+    // Each round they may land on an opponent's property and pay rent, and opponents may land on theirs
+    double ruinProbability(int cashBand, int ownHoldings, int opponentHoldings, int opponents) const {
+        const int horizon = ruinHorizon;
+        double payChance = min(1.0, opponentHoldings / 40.0);
+        double earnChance = min(1.0, opponents * ownHoldings / 40.0);
+        double stayChance = payChance * earnChance + (1 - payChance) * (1 - earnChance);
+
+        int states = cashBand + horizon + 1;
+        vector<double> chance(states, 0.0);
+        vector<double> next(states);
+        chance[cashBand] = 1.0;
+        double ruined = 0;
+        for (int round = 0; round < horizon; ++round) {
+            fill(next.begin(), next.end(), 0.0);
+            for (int band = 0; band < states; ++band) {
+                if (chance[band] == 0) continue;
+                next[band] += chance[band] * stayChance;
+                next[min(band + 1, states - 1)] += chance[band] * (1 - payChance) * earnChance;
+                if (band == 0) {
+                    ruined += chance[band] * payChance * (1 - earnChance); // Rent exceeds the remaining cash
+                } else {
+                    next[band - 1] += chance[band] * payChance * (1 - earnChance);
+                }
+            }
+            swap(chance, next);
+        }
+        return ruined;
+    }
+
+    // Make a yes/no AI decision, taken from the decision script when one is set
+    bool aiDecision() {
+        if (decisionScript) {
+            if (decisionIndex < decisionScript->size()) {
+                return (*decisionScript)[decisionIndex++] != 0;
+            }
+            return false; // AI declines once the script runs out
+        }
+        return std::uniform_int_distribution<int>(0, 1)(rng) == 0;
     }
 
     // Display the current state of the board
     void displayBoard() const {
+        if (!out.rdbuf()) return; // Nothing to draw when output is silenced
+
         list<string> board(40, "[ ]");
 
         // Use iterators to place players on the board
@@ -309,53 +776,60 @@ public:
             }
         }
 
-        cout << "\nBoard State:\n";
+        out << "\nBoard State:\n";
         int count = 0;
         for (const auto& space : board) {
-            cout << space;
+            out << space;
             count++;
             if (count % 10 == 0) {
-                cout << endl;
+                out << endl;
             }
         }
-        cout << endl;
+        out << endl;
     }
 
     // Handle actions for when a player lands on a special space (e.g., Go, Jail)
     void handleSpecialSpace(Player& player, int position) {
-        string spaceName = specialSpaces[position];
-        cout << player.name << " landed on " << spaceName << endl;
+        const string& spaceName = specialSpaces[position];
+        out << player.name << " landed on " << spaceName << endl;
         if (spaceName == "Go") {
             player.money += 200; // Player collects $200 for landing on or passing Go
-            cout << player.name << " collects $200 for landing on Go." << endl;
+            bankFlow += 200;
+            publishEvent(GameEvent::Salary, player, position, 200);
+            out << player.name << " collects $200 for landing on Go." << endl;
         } else if (spaceName == "Income Tax") {
             // Player pays either 10% of their total money or $200, whichever is lower
             int tax = min(200, static_cast<int>(player.money * 0.1));
             player.money -= tax;
+            bankFlow -= tax;
+            publishEvent(GameEvent::Tax, player, position, tax);
             if (player.money < 0) {
                 handleBankruptcy(player);
                 return;
             }
-            cout << player.name << " pays Income Tax of $" << tax << endl;
+            out << player.name << " pays Income Tax of $" << tax << endl;
         } else if (spaceName == "Go to Jail") {
             // Player is sent to Jail
             player.inJail = true;
             player.position = 10; // Jail position is 10
-            cout << player.name << " is sent to Jail!" << endl;
+            publishEvent(GameEvent::GoToJail, player, player.position);
+            out << player.name << " is sent to Jail!" << endl;
         } else if (spaceName == "Luxury Tax") {
             // Player pays a luxury tax of $100
             player.money -= 100;
+            bankFlow -= 100;
+            publishEvent(GameEvent::Tax, player, position, 100);
             if (player.money < 0) {
                 handleBankruptcy(player);
                 return;
             }
-            cout << player.name << " pays Luxury Tax of $100." << endl;
+            out << player.name << " pays Luxury Tax of $100." << endl;
         } else if (spaceName == "Free Parking") {
             // Free Parking does nothing, it's just a resting space
-            cout << player.name << " is on Free Parking. Nothing happens." << endl;
+            out << player.name << " is on Free Parking. Nothing happens." << endl;
         } else if (spaceName == "Jail") {
             // Player is just visiting Jail, not actually in Jail
-            cout << player.name << " is just visiting Jail." << endl;
+            out << player.name << " is just visiting Jail." << endl;
         }
     }
 
@@ -363,26 +837,28 @@ public:
     void handleJailTurn(Player& player) {
         if (player.jailTurns < 3) {
             // Player attempts to roll doubles to get out of Jail
-            cout << player.name << " is in jail. Attempting to roll a double to get out..." << endl;
+            out << player.name << " is in jail. Attempting to roll a double to get out..." << endl;
             std::uniform_int_distribution<int> dist(1, 6);
             int roll1 = dist(rng);
             int roll2 = dist(rng);
-            cout << "Rolled: " << roll1 << " and " << roll2 << endl;
+            out << "Rolled: " << roll1 << " and " << roll2 << endl;
             if (roll1 == roll2) {
                 // Player rolled a double and gets out of Jail
-                cout << player.name << " rolled a double and is free from jail!" << endl;
+                out << player.name << " rolled a double and is free from jail!" << endl;
                 player.inJail = false;
                 player.jailTurns = 0;
+                publishEvent(GameEvent::LeaveJail, player, player.position);
             } else {
                 // Player did not roll a double, must stay in Jail
                 player.jailTurns++;
-                cout << player.name << " did not roll a double and must stay in jail." << endl;
+                out << player.name << " did not roll a double and must stay in jail." << endl;
             }
         } else {
             // Player has served 3 turns and is automatically released
-            cout << player.name << " has served 3 turns in jail and is now free." << endl;
+            out << player.name << " has served 3 turns in jail and is now free." << endl;
             player.inJail = false;
             player.jailTurns = 0;
+            publishEvent(GameEvent::LeaveJail, player, player.position);
         }
     }
 
@@ -392,15 +868,15 @@ public:
         if (player.bankrupt) return;
 
         // Display properties that the player owns which are not mortgaged
-        cout << "Properties you own: " << endl;
+        out << "Properties you own: " << endl;
         for (const auto& property : player.propertiesOwned) {
             if (!mortgagedProperties[property]) {
-                cout << property << endl;
+                out << property << endl;
             }
         }
 
         // Ask the player which property they want to mortgage
-        cout << "Enter the property you want to mortgage: ";
+        out << "Enter the property you want to mortgage: ";
         string propertyName;
         cin.ignore();
         getline(cin, propertyName);
@@ -408,11 +884,14 @@ public:
         // Check if the player owns the property and if it is not already mortgaged
         if (player.propertiesOwned.find(propertyName) != player.propertiesOwned.end() && !mortgagedProperties[propertyName]) {
             mortgagedProperties[propertyName] = true; // Mark property as mortgaged
+            ownershipChanges++;
             player.money += 50; // Mortgage value is $50 for simplicity
-            cout << propertyName << " has been mortgaged. You received $50." << endl;
+            bankFlow += 50;
+            publishEvent(GameEvent::Mortgage, player, positionOf(propertyName), 50);
+            out << propertyName << " has been mortgaged. You received $50." << endl;
         } else {
             // Invalid property or already mortgaged
-            cout << "Invalid property or already mortgaged." << endl;
+            out << "Invalid property or already mortgaged." << endl;
         }
     }
 
@@ -421,50 +900,50 @@ public:
         if (player.bankrupt) return; // Skip if player is bankrupt
 
         // Get the name of the player they want to trade with
-        cout << "Enter the name of the player you want to trade with: ";
+        out << "Enter the name of the player you want to trade with: ";
         string otherPlayerName;
         cin.ignore();
         getline(cin, otherPlayerName);
 
         auto maybeOtherPlayer = findPlayer(otherPlayerName);
         if (!maybeOtherPlayer) {
-            cout << "Player not found." << endl;
+            out << "Player not found." << endl;
             return;
         }
 
         Player& otherPlayer = maybeOtherPlayer.value().get();
 
         // Display the properties owned by the player initiating the trade
-        cout << "Properties you own: " << endl;
+        out << "Properties you own: " << endl;
         for (const auto& property : player.propertiesOwned) {
-            cout << property << endl;
+            out << property << endl;
         }
 
         // Ask the player to choose a property to trade
-        cout << "Enter the property you want to trade: ";
+        out << "Enter the property you want to trade: ";
         string playerProperty;
         getline(cin, playerProperty);
 
         // Validate if the player owns the property
         if (player.propertiesOwned.find(playerProperty) == player.propertiesOwned.end()) {
-            cout << "You do not own this property." << endl;
+            out << "You do not own this property." << endl;
             return;
         }
 
         // Display the properties owned by the other player
-        cout << otherPlayer.name << "'s properties: " << endl;
+        out << otherPlayer.name << "'s properties: " << endl;
         for (const auto& property : otherPlayer.propertiesOwned) {
-            cout << property << endl;
+            out << property << endl;
         }
 
         // Ask for the property the player wants in return
-        cout << "Enter the property you want in return: ";
+        out << "Enter the property you want in return: ";
         string otherProperty;
         getline(cin, otherProperty);
 
         // Validate if the other player owns the property
         if (otherPlayer.propertiesOwned.find(otherProperty) == otherPlayer.propertiesOwned.end()) {
-            cout << "The other player does not own this property." << endl;
+            out << "The other player does not own this property." << endl;
             return;
         }
 
@@ -475,12 +954,21 @@ public:
         otherPlayer.propertiesOwned.insert(playerProperty);
         propertyOwners[playerProperty] = otherPlayer.name;
         propertyOwners[otherProperty] = player.name;
-        cout << "Trade successful! " << player.name << " traded " << playerProperty << " for " << otherProperty << " with " << otherPlayer.name << endl;
+
+        // Upgrades stay on the properties, so they move to the new owners along with them
+        int playerUpgrades = player.propertyUpgrades[playerProperty];
+        int otherUpgrades = otherPlayer.propertyUpgrades[otherProperty];
+        player.propertyUpgrades.erase(playerProperty);
+        otherPlayer.propertyUpgrades.erase(otherProperty);
+        player.propertyUpgrades[otherProperty] = otherUpgrades;
+        otherPlayer.propertyUpgrades[playerProperty] = playerUpgrades;
+        ownershipChanges++;
+        out << "Trade successful! " << player.name << " traded " << playerProperty << " for " << otherProperty << " with " << otherPlayer.name << endl;
     }
 
     // Start an auction for a property
     void auctionProperty(const string& propertyName, int startingBid = 10, int bidIncrement = 5) {
-        cout << "Starting auction for " << propertyName << "! Starting bid is $" << startingBid << " with bid increment of $" << bidIncrement << "." << endl;
+        out << "Starting auction for " << propertyName << "! Starting bid is $" << startingBid << " with bid increment of $" << bidIncrement << "." << endl;
 
         priority_queue<Bid> bidQueue;
 
@@ -490,10 +978,18 @@ public:
 
             int bid = 0;
             if (player.isAI) {
-                bid = (rand() % 2 == 0) ? startingBid : 0;
-                cout << player.name << " (AI) bids: " << (bid > 0 ? to_string(bid) : "Pass") << endl;
+                bool wantsToBid;
+                if (player.controlledAction >= 0) {
+                    wantsToBid = player.controlledAction & bidAction;
+                } else if (aiPolicy == AIPolicy::Valuation) {
+                    wantsToBid = valuationDecision(player, startingBid);
+                } else {
+                    wantsToBid = aiDecision();
+                }
+                bid = wantsToBid ? startingBid : 0;
+                out << player.name << " (AI) bids: " << (bid > 0 ? to_string(bid) : "Pass") << endl;
             } else {
-                cout << player.name << ", enter your bid (or 0 to pass, must be at least $" << startingBid << "): ";
+                out << player.name << ", enter your bid (or 0 to pass, must be at least $" << startingBid << "): ";
                 cin >> bid;
             }
 
@@ -506,11 +1002,12 @@ public:
         // Determine the winner
         if (!bidQueue.empty()) {
             Bid highestBid = bidQueue.top();
-            cout << highestBid.bidderName << " wins the auction for " << propertyName << " with a bid of $" << highestBid.amount << "!" << endl;
+            out << highestBid.bidderName << " wins the auction for " << propertyName << " with a bid of $" << highestBid.amount << "!" << endl;
 
             // Update ownership
             ownedProperties.insert(propertyName);
             propertyOwners[propertyName] = highestBid.bidderName;
+            ownershipChanges++;
 
             // Deduct money and add property to the winner
             auto winnerIt = std::find_if(players.begin(), players.end(),
@@ -519,12 +1016,14 @@ public:
                 winnerIt->propertiesOwned.insert(propertyName);
                 winnerIt->propertyUpgrades[propertyName] = 0;
                 winnerIt->money -= highestBid.amount;
+                bankFlow -= highestBid.amount;
+                publishEvent(GameEvent::AuctionWon, *winnerIt, positionOf(propertyName), highestBid.amount);
                 if (winnerIt->money < 0) {
                     handleBankruptcy(*winnerIt);
                 }
             }
         } else {
-            cout << "No bids were placed for the property." << endl;
+            out << "No bids were placed for the property." << endl;
         }
     }
 
@@ -532,7 +1031,7 @@ public:
     void drawCommunityChest(Player& player) {
         // If there are no community chest cards left, reshuffle
         if (communityChest.empty()) {
-            cout << "No community chest cards left. Reshuffling..." << endl;
+            out << "No community chest cards left. Reshuffling..." << endl;
             // Reinitialize and reshuffle
             list<string> communityChestCards = {
                 "Bank error in your favor. Collect $200.",
@@ -558,30 +1057,35 @@ public:
         // Draw the top card from the community chest stack
         string card = communityChest.top();
         communityChest.pop();
-        cout << "Community Chest: " << card << endl;
+        out << "Community Chest: " << card << endl;
 
         // Determine the effect of the drawn card
         if (card.find("Collect $") != string::npos) {
             size_t pos = card.find("$") + 1;
             int amount = stoi(card.substr(pos));
             player.money += amount;
-            cout << player.name << " collects $" << amount << " from Community Chest." << endl;
+            bankFlow += amount;
+            publishEvent(GameEvent::Card, player, player.position, amount);
+            out << player.name << " collects $" << amount << " from Community Chest." << endl;
         } else if (card.find("Pay $") != string::npos) {
             size_t pos = card.find("$") + 1;
             int amount = stoi(card.substr(pos));
             player.money -= amount;
+            bankFlow -= amount;
+            publishEvent(GameEvent::Card, player, player.position, -amount);
             if (player.money < 0) {
                 handleBankruptcy(player);
                 return;
             }
-            cout << player.name << " pays $" << amount << " for Community Chest card." << endl;
+            out << player.name << " pays $" << amount << " for Community Chest card." << endl;
         } else if (card == "Go to Jail. Go directly to jail, do not pass Go, do not collect $200.") {
             player.inJail = true;
             player.position = 10;
-            cout << player.name << " is sent to Jail!" << endl;
+            publishEvent(GameEvent::GoToJail, player, player.position);
+            out << player.name << " is sent to Jail!" << endl;
         } else if (card == "Get Out of Jail Free.") {
             // Implement logic to give player a get out of jail free card if desired
-            cout << player.name << " received a Get Out of Jail Free card." << endl;
+            out << player.name << " received a Get Out of Jail Free card." << endl;
         }
     }
 
@@ -589,45 +1093,69 @@ public:
     void upgradeProperty(Player& player) {
         if (player.bankrupt) return;
 
-        cout << "Do you want to upgrade a property? (y/n): ";
+        out << "Do you want to upgrade a property? (y/n): ";
         char choice;
         cin >> choice;
         if (choice == 'y') {
-            cout << "Properties you can upgrade: " << endl;
+            out << "Properties you can upgrade: " << endl;
             for (const auto& property : player.propertiesOwned) {
                 if (!mortgagedProperties[property]) {
-                    cout << property << " (Current Upgrades: " << player.propertyUpgrades[property] << ")" << endl;
+                    out << property << " (Current Upgrades: " << player.propertyUpgrades[property] << ")" << endl;
                 }
             }
-            cout << "Enter the property you want to upgrade: ";
+            out << "Enter the property you want to upgrade: ";
             string propertyName;
             cin.ignore();
             getline(cin, propertyName);
-            if (player.propertiesOwned.find(propertyName) != player.propertiesOwned.end() && !mortgagedProperties[propertyName]) {
-                if (player.money >= upgradeCost) {
-                    player.money -= upgradeCost;
-                    player.propertyUpgrades[propertyName]++;
-                    cout << propertyName << " has been upgraded. Total upgrades: " << player.propertyUpgrades[propertyName] << endl;
-                } else {
-                    cout << "You do not have enough money to upgrade this property." << endl;
-                }
+            applyUpgrade(player, propertyName);
+        }
+    }
+
+    // Upgrade a property owned by the player if it is not mortgaged and they can afford it
+    bool applyUpgrade(Player& player, const string& propertyName) {
+        if (player.propertiesOwned.find(propertyName) != player.propertiesOwned.end() && !mortgagedProperties[propertyName]) {
+            if (player.money >= upgradeCost) {
+                player.money -= upgradeCost;
+                bankFlow -= upgradeCost;
+                player.propertyUpgrades[propertyName]++;
+                publishEvent(GameEvent::Upgrade, player, positionOf(propertyName), upgradeCost);
+                out << propertyName << " has been upgraded. Total upgrades: " << player.propertyUpgrades[propertyName] << endl;
+                return true;
             } else {
-                cout << "Invalid property or property is mortgaged." << endl;
+                out << "You do not have enough money to upgrade this property." << endl;
             }
+        } else {
+            out << "Invalid property or property is mortgaged." << endl;
         }
+        return false;
     }
 
     // Handle bankruptcy of a player
     void handleBankruptcy(Player& player) {
-        cout << player.name << " is bankrupt! All properties are now up for auction." << endl;
+        out << player.name << " is bankrupt! All properties are now up for auction." << endl;
         player.bankrupt = true;
+        int debt = player.money;
+        bankFlow -= player.money; // The bank absorbs any outstanding debt
         player.money = 0;
+        publishEvent(GameEvent::Bankrupt, player, player.position, debt);
 
         // Auction off all player's properties
         for (const auto& property : player.propertiesOwned) {
             auctionProperty(property);
         }
+
+        // Properties nobody bid on return to the bank
+        for (const auto& property : player.propertiesOwned) {
+            auto ownerIt = propertyOwners.find(property);
+            if (ownerIt != propertyOwners.end() && ownerIt->second == player.name) {
+                propertyOwners.erase(ownerIt);
+                ownedProperties.erase(property);
+                mortgagedProperties.erase(property);
+            }
+        }
         player.propertiesOwned.clear();
+        player.propertyUpgrades.clear();
+        ownershipChanges++;
     }
 
     // Find a player by name
@@ -643,42 +1171,1647 @@ public:
 
     // Display all players and their current status
     void displayPlayersStatus() const {
-        cout << "\nCurrent Players Status:\n";
+        out << "\nCurrent Players Status:\n";
         for (const auto& player : players) {
-            cout << player.name << " - Money: $" << player.money << ", Position: " << player.position;
+            out << player.name << " - Money: $" << player.money << ", Position: " << player.position;
             if (player.inJail) {
-                cout << " (In Jail)";
+                out << " (In Jail)";
             }
-            cout << ", Bankrupt: " << (player.bankrupt ? "Yes" : "No") << endl;
+            out << ", Bankrupt: " << (player.bankrupt ? "Yes" : "No") << endl;
         }
     }
 
     // Calculate and display total wealth of each player
     void displayTotalWealth() const {
-        cout << "\nTotal Wealth of Each Player:\n";
+        out << "\nTotal Wealth of Each Player:\n";
         for (const auto& player : players) {
             int totalWealth = player.money;
             totalWealth += std::accumulate(player.propertiesOwned.begin(), player.propertiesOwned.end(), 0,
                 [this](int sum, const string& property) {
                     return sum + 100; // Assuming each property is worth $100
                 });
-            cout << player.name << " - Total Wealth: $" << totalWealth << endl;
+            out << player.name << " - Total Wealth: $" << totalWealth << endl;
         }
     }
 
+    // Estimate each player's probability of winning from cash, holdings, upgrades and board position
+    // Returns one probability per player in seating order
+    vector<double> estimateWinProbabilities() const {
+        int activePlayers = 0;
+        for (const auto& player : players) {
+            if (!player.bankrupt) activePlayers++;
+        }
+
+        vector<double> strengths;
+        double totalStrength = 0;
+        for (const auto& player : players) {
+            double equity = 0;
+            if (!player.bankrupt) {
+                equity = player.money;
+                for (const auto& property : player.propertiesOwned) {
+                    auto mortgageIt = mortgagedProperties.find(property);
+                    if (mortgageIt != mortgagedProperties.end() && mortgageIt->second) {
+                        equity += 50; // Mortgaged properties only hold their mortgage value
+                        continue;
+                    }
+                    auto upgradesIt = player.propertyUpgrades.find(property);
+                    int upgrades = upgradesIt != player.propertyUpgrades.end() ? upgradesIt->second : 0;
+                    // Resale value plus the rent expected from the other players over the next lap of the board;
+                    // moving 1-6 spaces a turn, a player lands on a given space about once every 3.5 laps
+                    equity += 100 + upgrades * upgradeCost;
+                    equity += rentPrices.at(property) * (1 + upgrades * rentMultiplier) * (activePlayers - 1) / 3.5;
+                }
+                // Players within one roll of Go may collect $200 on their next turn
+                int distanceToGo = 40 - player.position;
+                if (!player.inJail && distanceToGo <= 6) {
+                    equity += 200.0 / 6;
+                }
+            }
+            double strength = pow(max(equity, 0.0), winProbabilityExponent);
+            strengths.push_back(strength);
+            totalStrength += strength;
+        }
+
+        for (auto& strength : strengths) {
+            strength = totalStrength > 0 ? strength / totalStrength : 1.0 / strengths.size();
+        }
+        return strengths;
+    }
+
     // Remove bankrupt players from the game
     void removeBankruptPlayers() {
         players.remove_if([](const Player& player) { return player.bankrupt; });
     }
 };
 
+// A replayable fuzz case: board seed, number of AI players, turn budget and the scripted AI decisions
+struct FuzzCase {
+    unsigned int seed;
+    int numPlayers;
+    int maxTurns;
+    vector<int> decisions;
+};
+
+// A problem found while running a fuzz case
+struct FuzzFailure {
+    int turn; // Turn after which the problem was detected
+    string reason; // Description of the state mismatch or broken invariant
+};
+
+// Write a compact, engine-independent view of each player's state used to compare engines turn by turn
+void takePlayerSnapshot(const Board& board, vector<int>& state) {
+    state.clear();
+    for (const auto& player : board.players) {
+        state.insert(state.end(), {player.seat, player.money, player.position, player.inJail, player.jailTurns,
+                                   player.bankrupt, static_cast<int>(player.propertiesOwned.size())});
+    }
+}
+
+// Write the owner's seat (-1 for the bank) and mortgage flag of every space, indexed by board position
+void takeOwnershipSnapshot(const Board& board, vector<int>& state) {
+    state.assign(2 * 40, -1);
+    for (const auto& property : board.properties) {
+        int ownerSeat = -1;
+        auto ownerIt = board.propertyOwners.find(property.second);
+        if (ownerIt != board.propertyOwners.end()) {
+            auto seatIt = std::find_if(board.players.begin(), board.players.end(),
+                [&ownerIt](const Player& p) { return p.name == ownerIt->second; });
+            ownerSeat = seatIt != board.players.end() ? seatIt->seat : -2; // -2 for an owner who left the game
+        }
+        auto mortgageIt = board.mortgagedProperties.find(property.second);
+        bool mortgaged = mortgageIt != board.mortgagedProperties.end() && mortgageIt->second;
+        state[2 * property.first] = ownerSeat;
+        state[2 * property.first + 1] = mortgaged;
+    }
+}
+
+// Write the full comparable game state: players followed by ownership
+void takeSnapshot(const Board& board, vector<int>& state) {
+    vector<int> ownership;
+    takePlayerSnapshot(board, state);
+    takeOwnershipSnapshot(board, ownership);
+    state.insert(state.end(), ownership.begin(), ownership.end());
+}
+
+// Check that money is conserved and only bankrupt players are in debt, returning the first violation (empty if none)
+string checkMoneyInvariants(const Board& board) {
+    // Money is only created or destroyed by the bank, so all player money must match the bank's ledger
+    long long totalMoney = 0;
+    for (const auto& player : board.players) {
+        totalMoney += player.money;
+        if (!player.bankrupt && player.money < 0) {
+            return player.name + " has negative money without being bankrupt";
+        }
+    }
+    if (totalMoney != board.bankFlow) {
+        return "money not conserved: players hold $" + to_string(totalMoney) + " but the bank paid out $" + to_string(board.bankFlow);
+    }
+    return "";
+}
+
+// Check that propertyOwners, ownedProperties and each player's propertiesOwned agree, returning the first violation
+// (empty if none); ownership can only break when it changes, so callers may skip this while ownershipChanges is unchanged
+string checkOwnershipInvariants(const Board& board) {
+    for (const auto& player : board.players) {
+        if (player.bankrupt && !player.propertiesOwned.empty()) {
+            return player.name + " is bankrupt but still owns properties";
+        }
+        for (const auto& property : player.propertiesOwned) {
+            auto ownerIt = board.propertyOwners.find(property);
+            if (ownerIt == board.propertyOwners.end() || ownerIt->second != player.name) {
+                return player.name + " holds " + property + " without being its recorded owner";
+            }
+        }
+    }
+
+    // Every owned property must have exactly one owner who is still in the game and holds it
+    if (board.ownedProperties.size() != board.propertyOwners.size()) {
+        return "ownedProperties and propertyOwners disagree on the number of owned properties";
+    }
+    for (const auto& owner : board.propertyOwners) {
+        if (board.ownedProperties.find(owner.first) == board.ownedProperties.end()) {
+            return owner.first + " has an owner but is not marked as owned";
+        }
+        auto ownerIt = std::find_if(board.players.begin(), board.players.end(),
+            [&owner](const Player& p) { return p.name == owner.second; });
+        if (ownerIt == board.players.end()) {
+            return owner.first + " is owned by " + owner.second + " who is no longer in the game";
+        }
+        if (ownerIt->bankrupt) {
+            return owner.first + " is owned by bankrupt player " + owner.second;
+        }
+        if (ownerIt->propertiesOwned.find(owner.first) == ownerIt->propertiesOwned.end()) {
+            return owner.first + " is owned by " + owner.second + " but missing from their properties";
+        }
+    }
+    return "";
+}
+
+// Check every bookkeeping invariant of a board, returning a description of the first violation (empty if none)
+string checkInvariants(const Board& board) {
+    string violation = checkMoneyInvariants(board);
+    return violation.empty() ? checkOwnershipInvariants(board) : violation;
+}
+
+// Build the fuzz case with the given index; the same base seed and index always give the same case
+FuzzCase makeFuzzCase(unsigned int baseSeed, long long index, int maxTurns) {
+    std::seed_seq seeds{baseSeed, static_cast<unsigned int>(index), static_cast<unsigned int>(index >> 32)};
+    std::mt19937 caseRng(seeds);
+    FuzzCase fuzzCase;
+    fuzzCase.seed = caseRng();
+    fuzzCase.numPlayers = std::uniform_int_distribution<int>(2, 6)(caseRng);
+    fuzzCase.maxTurns = maxTurns;
+    fuzzCase.decisions.resize(maxTurns * 2); // Enough for a purchase and an auction bid per turn on average
+    for (auto& decision : fuzzCase.decisions) {
+        decision = caseRng() & 1;
+    }
+    return fuzzCase;
+}
+
+// Seat the AI players of a fuzz case and make them follow its decision script
+template <typename Engine>
+void setupFuzzGame(Engine& engine, const FuzzCase& fuzzCase) {
+    for (int i = 0; i < fuzzCase.numPlayers; ++i) {
+        engine.addPlayer("AI " + to_string(i + 1), true);
+    }
+    engine.decisionScript = &fuzzCase.decisions;
+}
+
+// Engine fuzzed and replayed against the reference Board. A candidate engine must provide:
+// - a (seed, verbose) constructor, addPlayer(name, isAI) and a decisionScript pointer, as Board does
+// - playNextTurn(), returning false once the game is over
+// - an ownershipChanges counter that moves whenever its ownership or mortgage state may have changed
+//   (only used to decide when to compare ownership, never compared itself)
+// - takePlayerSnapshot() and takeOwnershipSnapshot() overloads writing the same layout as Board's
+using FuzzCandidate = Board;
+
+// Run a fuzz case through the reference engine and a candidate engine in lockstep, comparing
+// their state and checking the reference invariants after every turn
+template <typename CandidateEngine>
+optional<FuzzFailure> runFuzzCase(const FuzzCase& fuzzCase, long long& turnsPlayed) {
+    Board reference(fuzzCase.seed, false);
+    CandidateEngine candidate(fuzzCase.seed, false);
+    setupFuzzGame(reference, fuzzCase);
+    setupFuzzGame(candidate, fuzzCase);
+
+    vector<int> referenceState;
+    vector<int> candidateState;
+    int referenceOwnershipChecked = -1; // Each engine's ownership change count at the last ownership comparison
+    int candidateOwnershipChecked = -1;
+    for (int turn = 1; turn <= fuzzCase.maxTurns; ++turn) {
+        bool referenceRunning = reference.playNextTurn();
+        bool candidateRunning = candidate.playNextTurn();
+        turnsPlayed++;
+
+        takePlayerSnapshot(reference, referenceState);
+        takePlayerSnapshot(candidate, candidateState);
+        if (referenceState != candidateState) {
+            return FuzzFailure{turn, "candidate engine state differs from the reference"};
+        }
+        string violation = checkMoneyInvariants(reference);
+
+        // Ownership is compared and checked only on turns where either engine reports it may have changed
+        if (violation.empty() && (reference.ownershipChanges != referenceOwnershipChecked
+                                  || candidate.ownershipChanges != candidateOwnershipChecked)) {
+            referenceOwnershipChecked = reference.ownershipChanges;
+            candidateOwnershipChecked = candidate.ownershipChanges;
+            takeOwnershipSnapshot(reference, referenceState);
+            takeOwnershipSnapshot(candidate, candidateState);
+            if (referenceState != candidateState) {
+                return FuzzFailure{turn, "candidate engine ownership differs from the reference"};
+            }
+            violation = checkOwnershipInvariants(reference);
+        }
+        if (!violation.empty()) {
+            return FuzzFailure{turn, violation};
+        }
+        if (referenceRunning != candidateRunning) {
+            return FuzzFailure{turn, "engines disagree on whether the game is over"};
+        }
+        if (!referenceRunning) {
+            break;
+        }
+    }
+    return nullopt;
+}
+
+// Shrink a failing fuzz case: stop at the failing turn, then drop and zero decisions while it keeps failing
+template <typename CandidateEngine>
+FuzzCase shrinkFuzzCase(FuzzCase fuzzCase, FuzzFailure& failure) {
+    long long turnsPlayed = 0;
+    auto stillFails = [&](FuzzCase& candidate) {
+        candidate.maxTurns = min(candidate.maxTurns, failure.turn);
+        auto result = runFuzzCase<CandidateEngine>(candidate, turnsPlayed);
+        if (result) {
+            failure = *result;
+        }
+        return result.has_value();
+    };
+    stillFails(fuzzCase);
+
+    // Remove chunks of decisions, halving the chunk size each pass
+    for (size_t chunk = fuzzCase.decisions.size() / 2; chunk > 0; chunk /= 2) {
+        size_t start = 0;
+        while (start < fuzzCase.decisions.size()) {
+            FuzzCase candidate = fuzzCase;
+            auto first = candidate.decisions.begin() + start;
+            candidate.decisions.erase(first, first + min(chunk, candidate.decisions.size() - start));
+            if (stillFails(candidate)) {
+                fuzzCase = candidate;
+            } else {
+                start += chunk;
+            }
+        }
+    }
+
+    // Turn remaining "yes" decisions into "no" where possible
+    for (size_t i = 0; i < fuzzCase.decisions.size(); ++i) {
+        if (fuzzCase.decisions[i] == 0) continue;
+        FuzzCase candidate = fuzzCase;
+        candidate.decisions[i] = 0;
+        if (stillFails(candidate)) {
+            fuzzCase = candidate;
+        }
+    }
+
+    // Trailing "no" decisions are implied once the script runs out
+    while (!fuzzCase.decisions.empty() && fuzzCase.decisions.back() == 0) {
+        fuzzCase.decisions.pop_back();
+    }
+    stillFails(fuzzCase);
+    return fuzzCase;
+}
+
+// Format the command line that replays a fuzz case
+string replayCommand(const FuzzCase& fuzzCase) {
+    ostringstream command;
+    command << "--replay " << fuzzCase.seed << " " << fuzzCase.numPlayers << " " << fuzzCase.maxTurns;
+    for (size_t i = 0; i < fuzzCase.decisions.size(); ++i) {
+        command << (i == 0 ? " " : ",") << fuzzCase.decisions[i];
+    }
+    return command.str();
+}
+
+// Fuzz mode: --fuzz [cases] [threads] [maxTurns] [baseSeed]
+// Runs random games across worker threads and shrinks the first failure found to a replayable case
+int runFuzzMode(int argc, char* argv[]) {
+    long long numCases = argc > 2 ? atoll(argv[2]) : 10000;
+    int numThreads = argc > 3 ? atoi(argv[3]) : max(1u, thread::hardware_concurrency());
+    int maxTurns = argc > 4 ? atoi(argv[4]) : 1000;
+    unsigned int baseSeed = argc > 5 ? static_cast<unsigned int>(strtoul(argv[5], nullptr, 10)) : std::random_device{}();
+
+    atomic<long long> nextCase(0);
+    atomic<long long> totalTurns(0);
+    atomic<bool> failed(false);
+    mutex failureMutex;
+    optional<pair<FuzzCase, FuzzFailure>> firstFailure;
+
+    auto startTime = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; ++t) {
+        workers.emplace_back([&]() {
+            long long turnsPlayed = 0;
+            while (!failed) {
+                long long index = nextCase++;
+                if (index >= numCases) break;
+                FuzzCase fuzzCase = makeFuzzCase(baseSeed, index, maxTurns);
+                auto failure = runFuzzCase<FuzzCandidate>(fuzzCase, turnsPlayed);
+                if (failure) {
+                    lock_guard<mutex> lock(failureMutex);
+                    if (!firstFailure) {
+                        firstFailure = make_pair(fuzzCase, *failure);
+                    }
+                    failed = true;
+                }
+            }
+            totalTurns += turnsPlayed;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+    cout << "Fuzzed " << min(nextCase.load(), numCases) << " games (base seed " << baseSeed << ") on " << numThreads
+         << " threads: " << totalTurns << " turns in " << fixed << setprecision(2) << seconds << "s ("
+         << static_cast<long long>(totalTurns / seconds) << " turns/sec)" << endl;
+
+    if (!firstFailure) {
+        cout << "No differences or invariant violations found." << endl;
+        return 0;
+    }
+
+    FuzzFailure failure = firstFailure->second;
+    cout << "Failure after turn " << failure.turn << ": " << failure.reason << endl;
+    FuzzCase minimal = shrinkFuzzCase<FuzzCandidate>(firstFailure->first, failure);
+    cout << "Shrunk to " << minimal.maxTurns << " turns and " << minimal.decisions.size() << " decisions: "
+         << failure.reason << " (turn " << failure.turn << ")" << endl;
+    cout << "Replay with: " << replayCommand(minimal) << endl;
+    return 1;
+}
+
+// Replay mode: --replay <seed> <players> <turns> [decisions]
+// Reruns a fuzz case in lockstep against the candidate engine, then narrates the reference game up to
+// the failure (or to the end) with full game output, checking invariants after every turn
+int runReplayMode(int argc, char* argv[]) {
+    if (argc < 5) {
+        cout << "Usage: --replay <seed> <players> <turns> [comma-separated decisions]" << endl;
+        return 2;
+    }
+    FuzzCase fuzzCase;
+    fuzzCase.seed = static_cast<unsigned int>(strtoul(argv[2], nullptr, 10));
+    fuzzCase.numPlayers = atoi(argv[3]);
+    fuzzCase.maxTurns = atoi(argv[4]);
+    if (argc > 5) {
+        stringstream decisions(argv[5]);
+        string decision;
+        while (getline(decisions, decision, ',')) {
+            fuzzCase.decisions.push_back(stoi(decision));
+        }
+    }
+
+    long long turnsPlayed = 0;
+    auto failure = runFuzzCase<FuzzCandidate>(fuzzCase, turnsPlayed);
+    int narratedTurns = failure ? failure->turn : fuzzCase.maxTurns;
+
+    Board board(fuzzCase.seed);
+    setupFuzzGame(board, fuzzCase);
+    for (int turn = 1; turn <= narratedTurns; ++turn) {
+        bool running = board.playNextTurn();
+        string violation = checkInvariants(board);
+        if (!violation.empty()) {
+            cout << "Invariant violated after turn " << turn << ": " << violation << endl;
+            return 1;
+        }
+        if (!running) break;
+    }
+    board.displayPlayersStatus();
+    if (failure) {
+        cout << "Replay failed after turn " << failure->turn << ": " << failure->reason << endl;
+        return 1;
+    }
+    cout << "Replay finished after " << board.turnCount << " turns with the engines agreeing and all invariants holding." << endl;
+    return 0;
+}
+
+// Settings for batch simulations of AI-only games
+struct SimulationOptions {
+    int numPlayers = 4; // Number of AI players in each game
+    double adjudicationThreshold = 0; // Win probability at which a game is decided early (0 plays games out)
+    int turnLimit = 0; // Turn at which an unfinished game is decided in favour of the leader (0 for no limit)
+    int minTurns = 40; // Turns played before the evaluator may decide a game
+    int maxTurns = 100000; // Safety cap on the length of played-out games
+    Board::AIPolicy aiPolicy = Board::AIPolicy::Random; // How the AI players decide to buy and bid
+    DecisionCache* decisionCache = nullptr; // Optional decision cache shared by all simulated games
+};
+
+// Outcome of one simulated game
+struct GameResult {
+    int winnerSeat; // Seat (0-based) of the winner or of the leader when the game was adjudicated
+    int turns; // Turns played
+    bool adjudicated; // True when the game was decided by the evaluator or a turn limit
+    uint64_t finalStateHash; // Hash of the state the game ended in
+};
+
+// Seat number (0-based) of a simulated player
+int seatOf(const Player& player) {
+    return player.seat;
+}
+
+// Seat of the player the evaluator currently favours
+int leaderSeat(const Board& board, double* probability = nullptr) {
+    vector<double> probabilities = board.estimateWinProbabilities();
+    auto best = std::max_element(probabilities.begin(), probabilities.end());
+    auto leaderIt = board.players.begin();
+    advance(leaderIt, std::distance(probabilities.begin(), best));
+    if (probability) {
+        *probability = *best;
+    }
+    return seatOf(*leaderIt);
+}
+
+// Check whether the game should be adjudicated now, storing the leader's seat if so
+bool shouldAdjudicate(const Board& board, const SimulationOptions& options, int& winnerSeat) {
+    if (options.turnLimit > 0 && board.turnCount >= options.turnLimit) {
+        winnerSeat = leaderSeat(board);
+        return true;
+    }
+    // The evaluator only runs once per round to keep its cost well below the cost of the turns it saves
+    // (a round has ended when the turn cursor has passed the last remaining seat)
+    bool roundEnd = board.turnCursor >= board.players.size();
+    if (options.adjudicationThreshold > 0 && roundEnd && board.turnCount >= options.minTurns) {
+        double probability = 0;
+        int seat = leaderSeat(board, &probability);
+        if (probability >= options.adjudicationThreshold) {
+            winnerSeat = seat;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Simulate one silent AI-only game from a seed, stopping early when the options allow it
+GameResult simulateGame(unsigned int seed, const SimulationOptions& options) {
+    Board board(seed, false);
+    board.aiPolicy = options.aiPolicy;
+    board.decisionCache = options.decisionCache;
+    for (int i = 0; i < options.numPlayers; ++i) {
+        board.addPlayer("AI " + to_string(i + 1), true);
+    }
+
+    GameResult result{-1, 0, false, 0};
+    while (board.playNextTurn()) {
+        if (shouldAdjudicate(board, options, result.winnerSeat)) {
+            result.adjudicated = true;
+            break;
+        }
+        if (board.turnCount >= options.maxTurns) {
+            result.winnerSeat = leaderSeat(board);
+            result.adjudicated = true;
+            break;
+        }
+    }
+    if (!result.adjudicated) {
+        result.winnerSeat = seatOf(board.players.front());
+    }
+    result.turns = board.turnCount;
+
+    // FNV-1a hash of the final state snapshot
+    vector<int> state;
+    takeSnapshot(board, state);
+    result.finalStateHash = 14695981039346656037ull;
+    for (int value : state) {
+        result.finalStateHash = (result.finalStateHash ^ static_cast<uint32_t>(value)) * 1099511628211ull;
+    }
+    return result;
+}
+
+// Simulation mode: --simulate [games] [threshold] [turnLimit] [players] [baseSeed]
+// Plays every game out in full and reports how often, and how much sooner, adjudication picks the real winner
+int runSimulateMode(int argc, char* argv[]) {
+    int numGames = argc > 2 ? atoi(argv[2]) : 1000;
+    SimulationOptions options;
+    options.adjudicationThreshold = argc > 3 ? atof(argv[3]) : 0.9;
+    options.turnLimit = argc > 4 ? atoi(argv[4]) : 0;
+    options.numPlayers = argc > 5 ? atoi(argv[5]) : 4;
+    unsigned int baseSeed = argc > 6 ? static_cast<unsigned int>(strtoul(argv[6], nullptr, 10)) : std::random_device{}();
+
+    int decided = 0, correct = 0, unfinished = 0;
+    long long fullTurns = 0, adjudicatedTurns = 0;
+    double fullSeconds = 0, adjudicatedSeconds = 0;
+
+    for (int game = 0; game < numGames; ++game) {
+        Board board(baseSeed + game, false);
+        for (int i = 0; i < options.numPlayers; ++i) {
+            board.addPlayer("AI " + to_string(i + 1), true);
+        }
+
+        // Play the game out, noting the moment and verdict of the adjudication along the way
+        auto startTime = chrono::steady_clock::now();
+        int predictedSeat = -1;
+        int predictedAt = 0;
+        double predictedSeconds = 0;
+        while (board.playNextTurn() && board.turnCount < options.maxTurns) {
+            if (predictedSeat < 0 && shouldAdjudicate(board, options, predictedSeat)) {
+                predictedAt = board.turnCount;
+                predictedSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+            }
+        }
+        double gameSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+        fullTurns += board.turnCount;
+        fullSeconds += gameSeconds;
+        if (predictedSeat < 0) {
+            // The evaluator never decided the game, so adjudication plays it out too
+            adjudicatedTurns += board.turnCount;
+            adjudicatedSeconds += gameSeconds;
+        } else {
+            adjudicatedTurns += predictedAt;
+            adjudicatedSeconds += predictedSeconds;
+        }
+
+        if (board.players.size() > 1) {
+            unfinished++; // Hit the safety cap, so there is no true winner to compare against
+        } else if (predictedSeat >= 0) {
+            decided++;
+            if (predictedSeat == seatOf(board.players.front())) {
+                correct++;
+            }
+        }
+    }
+
+    cout << fixed << setprecision(2);
+    cout << "Simulated " << numGames << " games with " << options.numPlayers << " AI players (base seed " << baseSeed
+         << ", threshold " << options.adjudicationThreshold << ", turn limit " << options.turnLimit << ")" << endl;
+    cout << "Played out:  " << fullTurns << " turns, " << fullSeconds << "s, "
+         << numGames / fullSeconds << " games/sec" << endl;
+    cout << "Adjudicated: " << adjudicatedTurns << " turns, " << adjudicatedSeconds << "s, "
+         << numGames / adjudicatedSeconds << " games/sec (" << fullSeconds / adjudicatedSeconds << "x faster)" << endl;
+    cout << "Adjudicated winner matched the played-out winner in " << correct << " of " << decided << " games ("
+         << (decided > 0 ? 100.0 * correct / decided : 0.0) << "%)";
+    if (unfinished > 0) {
+        cout << "; " << unfinished << " games hit the " << options.maxTurns << " turn cap";
+    }
+    cout << endl;
+    return 0;
+}
+
+// Mergeable summary of simulated games; every field combines exactly, so shards can be merged in any order
+struct SimulationSummary {
+    static const int sketchBits = 10; // HyperLogLog precision (2^10 registers)
+    long long games = 0; // Games summarised
+    long long adjudicated = 0; // Games decided by the evaluator, a turn limit or the safety cap
+    long long totalTurns = 0; // Turns played across all games
+    int shortestGame = 0; // Fewest turns in a game (0 when there are no games)
+    int longestGame = 0; // Most turns in a game
+    vector<long long> winsBySeat; // Games won by each seat
+    vector<long long> lengthHistogram = vector<long long>(32, 0); // Games counted by floor(log2(turns))
+    vector<int> finalStateSketch = vector<int>(1 << sketchBits, 0); // HyperLogLog registers over final state hashes
+
+    // Add one game to the summary
+    void add(const GameResult& result) {
+        games++;
+        adjudicated += result.adjudicated;
+        totalTurns += result.turns;
+        shortestGame = (games == 1) ? result.turns : min(shortestGame, result.turns);
+        longestGame = max(longestGame, result.turns);
+        if (result.winnerSeat >= static_cast<int>(winsBySeat.size())) {
+            winsBySeat.resize(result.winnerSeat + 1, 0);
+        }
+        winsBySeat[result.winnerSeat]++;
+
+        int lengthBucket = 0;
+        while ((result.turns >> (lengthBucket + 1)) > 0 && lengthBucket < 31) {
+            lengthBucket++;
+        }
+        lengthHistogram[lengthBucket]++;
+
+        // The top bits pick a register, which keeps the longest run of leading zeros seen in the rest
+        uint64_t hash = result.finalStateHash;
+        size_t reg = hash >> (64 - sketchBits);
+        uint64_t rest = (hash << sketchBits) | (1ull << (sketchBits - 1));
+        finalStateSketch[reg] = max(finalStateSketch[reg], __builtin_clzll(rest) + 1);
+    }
+
+    // Combine another summary into this one
+    void merge(const SimulationSummary& other) {
+        if (other.games == 0) return;
+        shortestGame = (games == 0) ? other.shortestGame : min(shortestGame, other.shortestGame);
+        longestGame = max(longestGame, other.longestGame);
+        games += other.games;
+        adjudicated += other.adjudicated;
+        totalTurns += other.totalTurns;
+        winsBySeat.resize(max(winsBySeat.size(), other.winsBySeat.size()), 0);
+        for (size_t seat = 0; seat < other.winsBySeat.size(); ++seat) {
+            winsBySeat[seat] += other.winsBySeat[seat];
+        }
+        for (size_t bucket = 0; bucket < lengthHistogram.size(); ++bucket) {
+            lengthHistogram[bucket] += other.lengthHistogram[bucket];
+        }
+        for (size_t reg = 0; reg < finalStateSketch.size(); ++reg) {
+            finalStateSketch[reg] = max(finalStateSketch[reg], other.finalStateSketch[reg]);
+        }
+    }
+
+    // Estimate the number of distinct final game states from the HyperLogLog sketch
+    double distinctFinalStates() const {
+        double registers = finalStateSketch.size();
+        double sum = 0;
+        int emptyRegisters = 0;
+        for (int value : finalStateSketch) {
+            sum += ldexp(1.0, -value);
+            if (value == 0) emptyRegisters++;
+        }
+        double estimate = 0.7213 / (1 + 1.079 / registers) * registers * registers / sum;
+        if (estimate <= 2.5 * registers && emptyRegisters > 0) {
+            estimate = registers * log(registers / emptyRegisters); // Linear counting for small cardinalities
+        }
+        return estimate;
+    }
+
+    // Write the summary as "key values..." lines
+    void write(ostream& file) const {
+        file << "games " << games << "\n";
+        file << "adjudicated " << adjudicated << "\n";
+        file << "turns " << totalTurns << "\n";
+        file << "shortest " << shortestGame << "\n";
+        file << "longest " << longestGame << "\n";
+        file << "wins " << winsBySeat.size();
+        for (long long wins : winsBySeat) file << " " << wins;
+        file << "\nlengths";
+        for (long long count : lengthHistogram) file << " " << count;
+        file << "\nsketch";
+        for (int value : finalStateSketch) file << " " << value;
+        file << "\n";
+    }
+
+    // Read a summary written by write(), returning false if it is malformed
+    bool read(istream& file) {
+        auto expect = [&file](const string& key) {
+            string word;
+            return static_cast<bool>(file >> word) && word == key;
+        };
+        size_t seats = 0;
+        if (!expect("games") || !(file >> games)) return false;
+        if (!expect("adjudicated") || !(file >> adjudicated)) return false;
+        if (!expect("turns") || !(file >> totalTurns)) return false;
+        if (!expect("shortest") || !(file >> shortestGame)) return false;
+        if (!expect("longest") || !(file >> longestGame)) return false;
+        if (!expect("wins") || !(file >> seats)) return false;
+        winsBySeat.assign(seats, 0);
+        for (auto& wins : winsBySeat) {
+            if (!(file >> wins)) return false;
+        }
+        if (!expect("lengths")) return false;
+        for (auto& count : lengthHistogram) {
+            if (!(file >> count)) return false;
+        }
+        if (!expect("sketch")) return false;
+        for (auto& value : finalStateSketch) {
+            if (!(file >> value)) return false;
+        }
+        return true;
+    }
+};
+
+// A simulation split into shards that run in separate processes and share a results directory
+struct ShardedRun {
+    string directory; // Directory holding run.txt and the shard result files
+    long long numGames = 10000; // Total number of games; game i uses seed firstSeed + i
+    int numShards = 16; // Number of independent shards the games are split into
+    unsigned int firstSeed = 0; // Seed of the first game
+    SimulationOptions options; // Settings used for every game
+
+    // First game index and number of games in a shard
+    pair<long long, long long> shardRange(int shard) const {
+        long long first = numGames * shard / numShards;
+        long long last = numGames * (shard + 1) / numShards;
+        return {first, last - first};
+    }
+
+    // Path of the result file for a shard
+    string shardPath(int shard) const {
+        return directory + "/shard-" + to_string(shard) + ".txt";
+    }
+
+    // Text block describing the run, stored in run.txt and repeated at the top of every shard file
+    string configText() const {
+        ostringstream config;
+        config << setprecision(17);
+        config << "totalGames " << numGames << "\n";
+        config << "shards " << numShards << "\n";
+        config << "firstSeed " << firstSeed << "\n";
+        config << "players " << options.numPlayers << "\n";
+        config << "threshold " << options.adjudicationThreshold << "\n";
+        config << "turnLimit " << options.turnLimit << "\n";
+        config << "minTurns " << options.minTurns << "\n";
+        config << "maxTurns " << options.maxTurns << "\n";
+        return config.str();
+    }
+};
+
+// Read the number of lines configText() produces from a stream
+string readConfigText(istream& file) {
+    string config;
+    string line;
+    for (int i = 0; i < 8 && getline(file, line); ++i) {
+        config += line + "\n";
+    }
+    return config;
+}
+
+// Write a file atomically by writing a temporary file next to it and renaming it into place
+bool writeFileAtomically(const string& path, const string& contents) {
+    // Hosts sharing the directory may reuse pids, so the host name keeps temporary names unique
+    char hostName[256] = "";
+    gethostname(hostName, sizeof(hostName) - 1);
+    string tempPath = path + ".tmp." + hostName + "." + to_string(getpid());
+    {
+        ofstream file(tempPath, ios::trunc);
+        file << contents;
+        file.flush();
+        if (!file) {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+
+// Remove temporary files left behind by processes on this host that died while writing results.
+// Files from other hosts, or from processes that are still alive, may still be renamed into place and are kept.
+void removeStaleTempFiles(const string& directory) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return;
+    char hostName[256] = "";
+    gethostname(hostName, sizeof(hostName) - 1);
+    string ownSuffix = string(".tmp.") + hostName + ".";
+    int removed = 0;
+    while (dirent* entry = readdir(dir)) {
+        string name = entry->d_name;
+        size_t suffixAt = name.rfind(ownSuffix);
+        if (suffixAt == string::npos) continue;
+        string pidText = name.substr(suffixAt + ownSuffix.size());
+        if (pidText.empty() || pidText.find_first_not_of("0123456789") != string::npos) continue;
+        pid_t pid = static_cast<pid_t>(atol(pidText.c_str()));
+        bool processDead = kill(pid, 0) != 0 && errno == ESRCH;
+        if (processDead && std::remove((directory + "/" + name).c_str()) == 0) {
+            removed++;
+        }
+    }
+    closedir(dir);
+    if (removed > 0) {
+        cout << "Removed " << removed << " stale temporary files" << endl;
+    }
+}
+
+// Load a run's settings from run.txt in its directory
+bool loadShardedRun(ShardedRun& run) {
+    ifstream file(run.directory + "/run.txt");
+    string header;
+    if (!getline(file, header) || header != "monopoly-run 1") {
+        return false;
+    }
+    auto expect = [&file](const string& key) {
+        string word;
+        return static_cast<bool>(file >> word) && word == key;
+    };
+    return expect("totalGames") && (file >> run.numGames) && expect("shards") && (file >> run.numShards)
+        && expect("firstSeed") && (file >> run.firstSeed) && expect("players") && (file >> run.options.numPlayers)
+        && expect("threshold") && (file >> run.options.adjudicationThreshold)
+        && expect("turnLimit") && (file >> run.options.turnLimit) && expect("minTurns") && (file >> run.options.minTurns)
+        && expect("maxTurns") && (file >> run.options.maxTurns) && run.numShards > 0;
+}
+
+// Load a shard's results, returning nullopt if the file is missing, incomplete or from a different run
+optional<SimulationSummary> loadShard(const ShardedRun& run, int shard) {
+    ifstream file(run.shardPath(shard));
+    string header;
+    if (!getline(file, header) || header != "monopoly-shard 1") {
+        return nullopt;
+    }
+    if (readConfigText(file) != run.configText()) {
+        return nullopt;
+    }
+    string word;
+    int fileShard = -1;
+    long long firstGame = -1, numGames = -1;
+    if (!(file >> word >> fileShard) || word != "shard" || fileShard != shard) return nullopt;
+    if (!(file >> word >> firstGame >> numGames) || word != "range") return nullopt;
+    if (make_pair(firstGame, numGames) != run.shardRange(shard)) return nullopt;
+
+    SimulationSummary summary;
+    if (!summary.read(file) || summary.games != numGames) {
+        return nullopt;
+    }
+    if (!(file >> word) || word != "end") {
+        return nullopt; // Truncated file
+    }
+    return summary;
+}
+
+// Simulate every game of a shard and write its result file
+bool runShard(const ShardedRun& run, int shard) {
+    auto range = run.shardRange(shard);
+    SimulationSummary summary;
+    for (long long game = range.first; game < range.first + range.second; ++game) {
+        summary.add(simulateGame(run.firstSeed + static_cast<unsigned int>(game), run.options));
+    }
+
+    ostringstream contents;
+    contents << "monopoly-shard 1\n" << run.configText();
+    contents << "shard " << shard << "\n";
+    contents << "range " << range.first << " " << range.second << "\n";
+    summary.write(contents);
+    contents << "end\n";
+    return writeFileAtomically(run.shardPath(shard), contents.str());
+}
+
+// Merge every completed shard of a run, print the combined results and write them to merged.txt
+// Returns 0 when all shards are present, or 1 after listing the ones still missing
+int mergeShardedRun(const ShardedRun& run) {
+    SimulationSummary total;
+    vector<int> missing;
+    for (int shard = 0; shard < run.numShards; ++shard) {
+        auto summary = loadShard(run, shard);
+        if (summary) {
+            total.merge(*summary);
+        } else {
+            missing.push_back(shard);
+        }
+    }
+
+    if (!missing.empty()) {
+        cout << missing.size() << " of " << run.numShards << " shards are missing or incomplete:";
+        for (int shard : missing) cout << " " << shard;
+        cout << "\nRerun --shard-run " << run.directory << " to complete them." << endl;
+        return 1;
+    }
+
+    ostringstream contents;
+    contents << "monopoly-merged 1\n" << run.configText();
+    total.write(contents);
+    contents << "end\n";
+    writeFileAtomically(run.directory + "/merged.txt", contents.str());
+
+    cout << fixed << setprecision(2);
+    cout << "Merged " << run.numShards << " shards: " << total.games << " games, " << total.totalTurns << " turns ("
+         << (total.games > 0 ? static_cast<double>(total.totalTurns) / total.games : 0.0) << " per game, shortest "
+         << total.shortestGame << ", longest " << total.longestGame << "), " << total.adjudicated << " adjudicated" << endl;
+    for (size_t seat = 0; seat < total.winsBySeat.size(); ++seat) {
+        cout << "  AI " << seat + 1 << " won " << total.winsBySeat[seat] << " games ("
+             << 100.0 * total.winsBySeat[seat] / total.games << "%)" << endl;
+    }
+    cout << "  Game lengths:";
+    for (size_t bucket = 0; bucket < total.lengthHistogram.size(); ++bucket) {
+        if (total.lengthHistogram[bucket] > 0) {
+            cout << " [" << (1 << bucket) << "," << (2ll << bucket) << "): " << total.lengthHistogram[bucket];
+        }
+    }
+    cout << "\n  Distinct final states: ~" << static_cast<long long>(total.distinctFinalStates()) << endl;
+    return 0;
+}
+
+// Sharded run mode: --shard-run <dir> [games] [shards] [processes] [firstSeed] [threshold] [turnLimit] [players]
+// Starts or resumes a run, forking up to the given number of shard processes at a time, then merges the results.
+// Resuming reuses the settings in <dir>/run.txt and only runs shards without a valid result file.
+int runShardRunMode(int argc, char* argv[]) {
+    if (argc < 3) {
+        cout << "Usage: --shard-run <dir> [games] [shards] [processes] [firstSeed] [threshold] [turnLimit] [players]" << endl;
+        return 2;
+    }
+    ShardedRun run;
+    run.directory = argv[2];
+    int numProcesses = argc > 5 ? atoi(argv[5]) : max(1u, thread::hardware_concurrency());
+
+    if (loadShardedRun(run)) {
+        cout << "Resuming run in " << run.directory << " (settings from run.txt)" << endl;
+        removeStaleTempFiles(run.directory);
+    } else {
+        run.numGames = argc > 3 ? atoll(argv[3]) : run.numGames;
+        run.numShards = argc > 4 ? atoi(argv[4]) : run.numShards;
+        run.firstSeed = argc > 6 ? static_cast<unsigned int>(strtoul(argv[6], nullptr, 10)) : std::random_device{}();
+        run.options.adjudicationThreshold = argc > 7 ? atof(argv[7]) : 0;
+        run.options.turnLimit = argc > 8 ? atoi(argv[8]) : 0;
+        run.options.numPlayers = argc > 9 ? atoi(argv[9]) : run.options.numPlayers;
+        mkdir(run.directory.c_str(), 0755);
+        if (!writeFileAtomically(run.directory + "/run.txt", "monopoly-run 1\n" + run.configText())) {
+            cout << "Could not write " << run.directory << "/run.txt" << endl;
+            return 1;
+        }
+    }
+
+    vector<int> pending;
+    for (int shard = 0; shard < run.numShards; ++shard) {
+        if (!loadShard(run, shard)) {
+            pending.push_back(shard);
+        }
+    }
+    cout << "Running " << pending.size() << " of " << run.numShards << " shards with up to " << numProcesses
+         << " processes" << endl;
+
+    // Keep up to numProcesses shard processes running until every pending shard has been attempted
+    auto startTime = chrono::steady_clock::now();
+    unordered_map<pid_t, int> running;
+    size_t nextPending = 0;
+    while (nextPending < pending.size() || !running.empty()) {
+        while (static_cast<int>(running.size()) < numProcesses && nextPending < pending.size()) {
+            int shard = pending[nextPending++];
+            cout.flush();
+            pid_t pid = fork();
+            if (pid == 0) {
+                _exit(runShard(run, shard) ? 0 : 1);
+            } else if (pid < 0) {
+                cout << "Could not start a process for shard " << shard << endl;
+            } else {
+                running[pid] = shard;
+            }
+        }
+        if (running.empty()) break;
+
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) break;
+        auto runningIt = running.find(pid);
+        if (runningIt == running.end()) continue;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            cout << "Shard " << runningIt->second << " failed" << endl;
+        }
+        running.erase(runningIt);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    cout << "Shards finished in " << fixed << setprecision(2) << seconds << "s" << endl;
+
+    return mergeShardedRun(run);
+}
+
+// Shard worker mode: --shard-worker <dir> <shard>
+// Runs a single shard of an existing run, e.g. when shards are spread across machines sharing <dir>
+int runShardWorkerMode(int argc, char* argv[]) {
+    if (argc < 4) {
+        cout << "Usage: --shard-worker <dir> <shard>" << endl;
+        return 2;
+    }
+    ShardedRun run;
+    run.directory = argv[2];
+    int shard = atoi(argv[3]);
+    if (!loadShardedRun(run) || shard < 0 || shard >= run.numShards) {
+        cout << "No run with shard " << shard << " in " << run.directory << endl;
+        return 2;
+    }
+    return runShard(run, shard) ? 0 : 1;
+}
+
+// Shard merge mode: --shard-merge <dir>
+// Combines the shard results of a run, listing any shards that still need to be run
+int runShardMergeMode(int argc, char* argv[]) {
+    if (argc < 3) {
+        cout << "Usage: --shard-merge <dir>" << endl;
+        return 2;
+    }
+    ShardedRun run;
+    run.directory = argv[2];
+    if (!loadShardedRun(run)) {
+        cout << "No run found in " << run.directory << endl;
+        return 2;
+    }
+    return mergeShardedRun(run);
+}
+
+// Play games [0, numGames) across worker threads, storing each result at its game index
+vector<GameResult> simulateGamesInParallel(int numGames, int numThreads, unsigned int baseSeed, const SimulationOptions& options) {
+    vector<GameResult> results(numGames);
+    atomic<int> nextGame(0);
+    vector<thread> workers;
+    for (int t = 0; t < numThreads; ++t) {
+        workers.emplace_back([&]() {
+            for (int game = nextGame++; game < numGames; game = nextGame++) {
+                results[game] = simulateGame(baseSeed + game, options);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return results;
+}
+
+// Print a decision cache's counters
+void printCacheStats(const DecisionCache& cache) {
+    DecisionCache::Stats stats = cache.stats();
+    uint64_t lookups = stats.hits + stats.misses;
+    cout << "  " << stats.hits << " hits, " << stats.misses << " misses ("
+         << (lookups > 0 ? 100.0 * stats.hits / lookups : 0.0) << "% hit rate), " << stats.collisions
+         << " collisions, " << stats.stores << " stores, " << stats.evictions << " evictions" << endl;
+}
+
+// Compare cached and freshly computed valuation decisions for low-cash players across a range of prices,
+// filling a shared cache in both ascending and descending order of cash; returns the number of mismatches
+int countCachedDecisionMismatches() {
+    Board board(1, false);
+    board.aiPolicy = Board::AIPolicy::Valuation;
+    board.addPlayer("AI 1", true);
+    board.addPlayer("AI 2", true);
+    Player& player = board.players.front();
+
+    int mismatches = 0;
+    for (bool ascending : {true, false}) {
+        DecisionCache cache(10);
+        for (int price : {10, 15, 50, 100}) {
+            for (int step = 0; step <= 60; ++step) {
+                player.money = 5 * (ascending ? step : 60 - step);
+                board.decisionCache = nullptr;
+                bool fresh = board.valuationDecision(player, price);
+                board.decisionCache = &cache;
+                if (board.valuationDecision(player, price) != fresh) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Decision cache benchmark: --cache-bench [threads] [games] [lookupsPerThread] [sizeLog2]
+// Measures raw shared lookup throughput, then valuation-policy games with and without the cache
+int runCacheBenchMode(int argc, char* argv[]) {
+    int numThreads = argc > 2 ? atoi(argv[2]) : max(1u, thread::hardware_concurrency());
+    int numGames = argc > 3 ? atoi(argv[3]) : 200;
+    long long lookupsPerThread = argc > 4 ? atoll(argv[4]) : 20000000;
+    int sizeLog2 = argc > 5 ? atoi(argv[5]) : 20;
+    if (sizeLog2 < DecisionCache::minSizeLog2 || sizeLog2 > DecisionCache::maxSizeLog2) {
+        cout << "sizeLog2 must be between " << DecisionCache::minSizeLog2 << " and " << DecisionCache::maxSizeLog2 << endl;
+        return 2;
+    }
+    cout << fixed << setprecision(2);
+
+    int mismatches = countCachedDecisionMismatches();
+    cout << "Affordability check: " << mismatches << " cached decisions differ from fresh ones for players with $0-$300" << endl;
+    if (mismatches > 0) {
+        return 1;
+    }
+
+    // Raw throughput: every thread looks up keys from a shared key space, storing on a miss
+    {
+        DecisionCache cache(sizeLog2);
+        auto startTime = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (int t = 0; t < numThreads; ++t) {
+            workers.emplace_back([&cache, lookupsPerThread, t]() {
+                uint64_t state = 0x9e3779b97f4a7c15ull * (t + 1);
+                for (long long i = 0; i < lookupsPerThread; ++i) {
+                    state ^= state << 13;
+                    state ^= state >> 7;
+                    state ^= state << 17;
+                    uint64_t key = (state & 0x3ffff) * 0x9e3779b97f4a7c15ull; // 2^18 distinct decision states
+                    int value = 0;
+                    if (!cache.lookup(key, value)) {
+                        cache.store(key, static_cast<int>(key & 1));
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        cout << "Raw lookups: " << numThreads * lookupsPerThread << " on " << numThreads << " threads in " << seconds
+             << "s (" << numThreads * lookupsPerThread / seconds / 1e6 << "M lookups/sec)" << endl;
+        printCacheStats(cache);
+    }
+
+    // Decision workload: every thread makes valuation decisions for random states in the ranges seen in play,
+    // first recomputing each one, then through one shared cache
+    long long decisionsPerThread = max(1ll, lookupsPerThread / 20);
+    auto runDecisions = [&](DecisionCache* cache, vector<uint64_t>& checksums) {
+        auto startTime = chrono::steady_clock::now();
+        vector<thread> workers;
+        for (int t = 0; t < numThreads; ++t) {
+            workers.emplace_back([&, t]() {
+                Board board(1, false);
+                board.decisionCache = cache;
+                std::mt19937 stateRng(t + 1);
+                uint64_t checksum = 0;
+                for (long long i = 0; i < decisionsPerThread; ++i) {
+                    uint32_t r = stateRng();
+                    bool decision = board.valuationDecision(r % 61, (r >> 8) % 11, (r >> 12) % 21, 1 + (r >> 20) % 5);
+                    checksum = checksum * 31 + decision;
+                }
+                checksums[t] = checksum;
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        return chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    };
+    {
+        vector<uint64_t> uncachedChecksums(numThreads);
+        vector<uint64_t> cachedChecksums(numThreads);
+        double uncachedSeconds = runDecisions(nullptr, uncachedChecksums);
+        DecisionCache cache(sizeLog2);
+        double cachedSeconds = runDecisions(&cache, cachedChecksums);
+        long long decisions = numThreads * decisionsPerThread;
+        cout << "Valuation decisions: " << decisions << " on " << numThreads << " threads, "
+             << decisions / uncachedSeconds / 1e6 << "M/sec without cache, " << decisions / cachedSeconds / 1e6
+             << "M/sec with cache (" << uncachedSeconds / cachedSeconds << "x faster)" << endl;
+        printCacheStats(cache);
+        if (uncachedChecksums != cachedChecksums) {
+            cout << "  Decisions DIFFER with and without the cache" << endl;
+            return 1;
+        }
+        cout << "  Decisions identical with and without the cache" << endl;
+    }
+
+    // Games with the valuation policy, first recomputing every decision, then sharing one cache.
+    // AI-only games make few valuation decisions, so the time difference here is mostly noise
+    SimulationOptions options;
+    options.aiPolicy = Board::AIPolicy::Valuation;
+    unsigned int baseSeed = 1;
+
+    auto startTime = chrono::steady_clock::now();
+    vector<GameResult> uncached = simulateGamesInParallel(numGames, numThreads, baseSeed, options);
+    double uncachedSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+    DecisionCache cache(sizeLog2);
+    options.decisionCache = &cache;
+    startTime = chrono::steady_clock::now();
+    vector<GameResult> cached = simulateGamesInParallel(numGames, numThreads, baseSeed, options);
+    double cachedSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+    bool identical = std::equal(uncached.begin(), uncached.end(), cached.begin(),
+        [](const GameResult& a, const GameResult& b) {
+            return a.winnerSeat == b.winnerSeat && a.turns == b.turns && a.finalStateHash == b.finalStateHash;
+        });
+    cout << "Valuation games: " << numGames << " on " << numThreads << " threads, " << uncachedSeconds
+         << "s without cache, " << cachedSeconds << "s with cache (" << uncachedSeconds / cachedSeconds << "x faster)" << endl;
+    printCacheStats(cache);
+    cout << "  Results " << (identical ? "identical" : "DIFFER") << " with and without the cache" << endl;
+    return identical ? 0 : 1;
+}
+
+// Batched training environment: N independent games in which seat 0 ("AI 1") is controlled by the caller
+// and the other seats are played by the board's AI. Observations, actions, rewards and done flags live in
+// caller-provided contiguous buffers, game i using the slice starting at i * observationSize (or i), so
+// stepping copies nothing beyond writing the observation in place. Games are stepped by a persistent pool
+// of worker threads. Each game keeps its board for its whole life and resets it in place between episodes.
+class MonopolyEnv {
+public:
+    static const int seatFeatures = 5; // position, money, inJail, jailTurns, bankrupt
+    static const int spaceFeatures = 3; // owner seat (-1 for none), owner's upgrades, mortgaged
+    static const int maxEpisodeTurns = 20000; // Turns after which an episode is cut off
+
+    // Action layout: Board::buyAction | Board::bidAction | (board position to upgrade + 1) << upgradeShift
+    static const int upgradeShift = 2;
+
+    // Create a batch of games with the given number of seats, stepped by numThreads threads
+    MonopolyEnv(int numGames, int numPlayers = 4, int numThreads = 1)
+        : numGames(numGames), numPlayers(numPlayers), boards(numGames), resetSeeds(numGames), episodeNumbers(numGames) {
+        for (int t = 1; t < numThreads; ++t) {
+            workers.emplace_back([this, t, numThreads]() { workerLoop(t, numThreads); });
+        }
+        numChunks = numThreads;
+    }
+
+    ~MonopolyEnv() {
+        {
+            lock_guard<mutex> lock(poolMutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Number of int32 values in one game's observation
+    int observationSize() const {
+        return 1 + numPlayers * seatFeatures + 40 * spaceFeatures;
+    }
+
+    // Start a new episode in every game from the given seeds and write the initial observations
+    void reset(const unsigned int* seeds, int32_t* observations) {
+        for (int game = 0; game < numGames; ++game) {
+            resetSeeds[game] = seeds[game];
+            episodeNumbers[game] = 0;
+            startEpisode(game);
+            writeObservation(game, observations + game * observationSize());
+        }
+    }
+
+    // Apply one action per game, play until it is seat 0's turn again, and write observations, rewards
+    // (+1 for winning, -1 for going bankrupt, 0 otherwise) and done flags. Finished games restart with
+    // a seed mixed from their reset seed and episode number and report the new episode's first observation.
+    void step(const int32_t* actions, int32_t* observations, float* rewards, uint8_t* dones) {
+        stepActions = actions;
+        stepObservations = observations;
+        stepRewards = rewards;
+        stepDones = dones;
+        if (workers.empty()) {
+            stepRange(0, numGames);
+            return;
+        }
+
+        {
+            lock_guard<mutex> lock(poolMutex);
+            generation++;
+            chunksLeft = numChunks - 1;
+        }
+        workAvailable.notify_all();
+        stepRange(0, numGames / numChunks);
+        unique_lock<mutex> lock(poolMutex);
+        workDone.wait(lock, [this]() { return chunksLeft == 0; });
+    }
+
+private:
+    // Seed of a game's current episode: the first episode uses the reset seed itself, later ones mix the
+    // reset seed with the episode number, so games never replay each other's episodes whatever seeds reset got
+    unsigned int episodeSeed(int game) const {
+        if (episodeNumbers[game] == 0) {
+            return resetSeeds[game];
+        }
+        std::seed_seq seeds{resetSeeds[game], episodeNumbers[game]};
+        unsigned int seed;
+        seeds.generate(&seed, &seed + 1);
+        return seed;
+    }
+
+    // Set up a game's board for its next episode, building the board only for the first one
+    void startEpisode(int game) {
+        if (boards[game]) {
+            boards[game]->reset(episodeSeed(game));
+        } else {
+            boards[game].reset(new Board(episodeSeed(game), false));
+        }
+        for (int i = 0; i < numPlayers; ++i) {
+            boards[game]->addPlayer("AI " + to_string(i + 1), true);
+        }
+    }
+
+    // Step the games in [first, last)
+    void stepRange(int first, int last) {
+        for (int game = first; game < last; ++game) {
+            stepGame(game);
+        }
+    }
+
+    // Step one game: seat 0 takes its turn with the given action, then every other seat plays
+    void stepGame(int game) {
+        Board& board = *boards[game];
+        Player& agent = board.players.front();
+        int action = stepActions[game];
+        agent.controlledAction = action & (Board::buyAction | Board::bidAction);
+
+        int upgradePosition = (action >> upgradeShift) - 1;
+        auto propertyIt = board.properties.find(upgradePosition);
+        if (propertyIt != board.properties.end()) {
+            board.applyUpgrade(agent, propertyIt->second);
+        }
+
+        // After seat 0's turn the cursor wraps back to 0 once every other remaining seat has played
+        bool running = board.playNextTurn();
+        while (running && seatOf(board.players.front()) == 0 && board.turnCursor != 0
+               && board.turnCursor < board.players.size()) {
+            running = board.playNextTurn();
+        }
+
+        bool agentAlive = seatOf(board.players.front()) == 0;
+        bool done = !running || !agentAlive || board.turnCount >= maxEpisodeTurns;
+        stepRewards[game] = !agentAlive ? -1.0f : (!running ? 1.0f : 0.0f);
+        stepDones[game] = done;
+        if (done) {
+            episodeNumbers[game]++;
+            startEpisode(game);
+        }
+        writeObservation(game, stepObservations + game * observationSize());
+    }
+
+    // Write a game's observation into its slice of the buffer
+    void writeObservation(int game, int32_t* observation) const {
+        const Board& board = *boards[game];
+        observation[0] = board.turnCount;
+
+        // Seats that have left the game read as bankrupt with no money
+        int32_t* seats = observation + 1;
+        for (int seat = 0; seat < numPlayers; ++seat) {
+            int32_t* features = seats + seat * seatFeatures;
+            features[0] = 0;
+            features[1] = 0;
+            features[2] = 0;
+            features[3] = 0;
+            features[4] = 1;
+        }
+        for (const auto& player : board.players) {
+            int32_t* features = seats + seatOf(player) * seatFeatures;
+            features[0] = player.position;
+            features[1] = player.money;
+            features[2] = player.inJail;
+            features[3] = player.jailTurns;
+            features[4] = player.bankrupt;
+        }
+
+        int32_t* spaces = seats + numPlayers * seatFeatures;
+        for (int position = 0; position < 40; ++position) {
+            spaces[position * spaceFeatures] = -1;
+            spaces[position * spaceFeatures + 1] = 0;
+            spaces[position * spaceFeatures + 2] = 0;
+        }
+        for (const auto& player : board.players) {
+            for (const auto& property : player.propertiesOwned) {
+                auto upgradesIt = player.propertyUpgrades.find(property);
+                auto mortgageIt = board.mortgagedProperties.find(property);
+                int32_t* features = spaces + propertyPositions.at(property) * spaceFeatures;
+                features[0] = seatOf(player);
+                features[1] = upgradesIt != player.propertyUpgrades.end() ? upgradesIt->second : 0;
+                features[2] = mortgageIt != board.mortgagedProperties.end() && mortgageIt->second;
+            }
+        }
+    }
+
+    // Worker thread: wait for a new step, play its chunk of games and report back
+    void workerLoop(int chunk, int chunks) {
+        long long seenGeneration = 0;
+        while (true) {
+            {
+                unique_lock<mutex> lock(poolMutex);
+                workAvailable.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = generation;
+            }
+            stepRange(numGames * chunk / chunks, numGames * (chunk + 1) / chunks);
+            {
+                lock_guard<mutex> lock(poolMutex);
+                chunksLeft--;
+            }
+            workDone.notify_one();
+        }
+    }
+
+    // Board position of every property, for writing ownership into observations
+    static unordered_map<string, int> makePropertyPositions() {
+        unordered_map<string, int> positions;
+        for (const auto& property : Board(0, false).properties) {
+            positions[property.second] = property.first;
+        }
+        return positions;
+    }
+
+    int numGames;
+    int numPlayers;
+    vector<unique_ptr<Board>> boards;
+    vector<unsigned int> resetSeeds; // Seed each game was last reset with
+    vector<unsigned int> episodeNumbers; // Episodes each game has finished since its last reset
+    const unordered_map<string, int> propertyPositions = makePropertyPositions();
+
+    // Buffers of the step in progress
+    const int32_t* stepActions = nullptr;
+    int32_t* stepObservations = nullptr;
+    float* stepRewards = nullptr;
+    uint8_t* stepDones = nullptr;
+
+    // Worker pool; the calling thread plays chunk 0 of each step
+    vector<thread> workers;
+    int numChunks = 1;
+    mutex poolMutex;
+    condition_variable workAvailable;
+    condition_variable workDone;
+    long long generation = 0;
+    int chunksLeft = 0;
+    bool stopping = false;
+};
+
+// Environment benchmark: --env-bench [threads] [gameSteps]
+// Measures game steps per second for batch sizes from 1 to 4096 with random actions
+int runEnvBenchMode(int argc, char* argv[]) {
+    int numThreads = argc > 2 ? atoi(argv[2]) : max(1u, thread::hardware_concurrency());
+    long long gameStepsPerBatch = argc > 3 ? atoll(argv[3]) : 200000;
+    cout << fixed << setprecision(0);
+
+    for (int batchSize = 1; batchSize <= 4096; batchSize *= 4) {
+        MonopolyEnv env(batchSize, 4, min(numThreads, batchSize));
+        vector<unsigned int> seeds(batchSize);
+        std::iota(seeds.begin(), seeds.end(), 1u);
+        vector<int32_t> observations(static_cast<size_t>(batchSize) * env.observationSize());
+        vector<int32_t> actions(batchSize);
+        vector<float> rewards(batchSize);
+        vector<uint8_t> dones(batchSize);
+        std::mt19937 actionRng(batchSize);
+        env.reset(seeds.data(), observations.data());
+
+        long long steps = max(10ll, gameStepsPerBatch / batchSize);
+        long long episodes = 0;
+        auto startTime = chrono::steady_clock::now();
+        for (long long step = 0; step < steps; ++step) {
+            for (auto& action : actions) {
+                action = actionRng() & 0xff; // Random buy/bid bits and upgrade target
+            }
+            env.step(actions.data(), observations.data(), rewards.data(), dones.data());
+            episodes += std::count(dones.begin(), dones.end(), 1);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        cout << "Batch " << setw(4) << batchSize << ": " << setw(9) << steps * batchSize / seconds
+             << " game steps/sec, " << setw(7) << steps / seconds << " batch steps/sec (" << episodes
+             << " episodes finished)" << endl;
+    }
+    return 0;
+}
+
+// Per-turn latency of a game played for the given number of turns, restarting with the next seed when a game ends
+vector<double> measureTurnLatencies(int numTurns, EventRing* ring) {
+    vector<double> latencies;
+    latencies.reserve(numTurns);
+    unsigned int seed = 1;
+    while (static_cast<int>(latencies.size()) < numTurns) {
+        Board board(seed++, false);
+        board.eventRing = ring;
+        for (int i = 0; i < 4; ++i) {
+            board.addPlayer("AI " + to_string(i + 1), true);
+        }
+        bool running = true;
+        while (running && static_cast<int>(latencies.size()) < numTurns) {
+            auto startTime = chrono::steady_clock::now();
+            running = board.playNextTurn();
+            latencies.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - startTime).count());
+        }
+    }
+    return latencies;
+}
+
+// Mean and tail of a set of turn latencies, in nanoseconds
+struct LatencySummary {
+    double mean;
+    double p999;
+};
+
+// Print the mean and percentiles of a set of turn latencies
+LatencySummary printLatencies(const string& label, vector<double> latencies) {
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+    double mean = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+    cout << label << ": mean " << mean << "ns, p50 " << percentile(0.5) << "ns, p99 " << percentile(0.99)
+         << "ns, p99.9 " << percentile(0.999) << "ns" << endl;
+    return {mean, percentile(0.999)};
+}
+
+// Spectator benchmark: --spectator-bench [consumers] [turns]
+// Measures the cost of publishing an event, then turn latency without spectators and with many consumers
+int runSpectatorBenchMode(int argc, char* argv[]) {
+    int numConsumers = argc > 2 ? atoi(argv[2]) : 100;
+    int numTurns = argc > 3 ? atoi(argv[3]) : 1000000;
+    cout << fixed << setprecision(1);
+
+    // Raw publish cost with nobody reading
+    {
+        EventRing ring;
+        const long long numEvents = 20000000;
+        GameEvent event{0, GameEvent::Move, 0, 255, 0, 0, 1500};
+        auto startTime = chrono::steady_clock::now();
+        for (long long i = 0; i < numEvents; ++i) {
+            event.turn = static_cast<uint32_t>(i);
+            ring.publish(event);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        cout << "Publish: " << seconds * 1e9 / numEvents << "ns per event" << endl;
+    }
+
+    printLatencies("No event ring        ", measureTurnLatencies(numTurns, nullptr));
+    EventRing quietRing;
+    LatencySummary quiet = printLatencies("Ring, no consumers   ", measureTurnLatencies(numTurns, &quietRing));
+
+    // Consumers read at their own pace and nap whenever they have caught up with the game
+    EventRing ring;
+    atomic<bool> stop(false);
+    vector<uint64_t> received(numConsumers, 0);
+    vector<uint64_t> missed(numConsumers, 0);
+    vector<thread> consumers;
+    for (int c = 0; c < numConsumers; ++c) {
+        consumers.emplace_back([&ring, &stop, &received, &missed, c]() {
+            EventSubscriber subscriber(ring);
+            GameEvent event;
+            uint64_t count = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                while (subscriber.poll(event)) {
+                    count++;
+                }
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            while (subscriber.poll(event)) {
+                count++;
+            }
+            received[c] = count;
+            missed[c] = subscriber.missed;
+        });
+    }
+    vector<double> latencies = measureTurnLatencies(numTurns, &ring);
+    stop = true;
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+    LatencySummary watched = printLatencies("Ring, " + to_string(numConsumers) + " consumers  ", latencies);
+
+    uint64_t totalReceived = std::accumulate(received.begin(), received.end(), uint64_t(0));
+    uint64_t totalMissed = std::accumulate(missed.begin(), missed.end(), uint64_t(0));
+    cout << ring.published() << " events published; consumers read " << totalReceived << " and detected "
+         << totalMissed << " overrun events in total" << endl;
+
+    // The game never waits on consumers, but consumer threads still compete with it for cores
+    double meanRatio = watched.mean / quiet.mean;
+    double tailRatio = watched.p999 / quiet.p999;
+    bool unaffected = meanRatio < 1.1 && tailRatio < 1.5;
+    cout << "With " << numConsumers << " consumers on " << thread::hardware_concurrency() << " hardware threads: mean "
+         << meanRatio << "x, p99.9 " << tailRatio << "x the latency without consumers; turn latency is "
+         << (unaffected ? "unaffected" : "AFFECTED") << endl;
+    return 0;
+}
+
+// Spectator that follows a game through its event ring on its own thread and writes every event to a
+// log file, one line each: turn, event type, seat, other seat, position, amount and the player's money
+class EventLogSpectator {
+public:
+    EventLogSpectator(const EventRing& ring, const string& path) : file(path), subscriber(ring) {
+        worker = thread([this]() { run(); });
+    }
+
+    // Log whatever the game published last, then stop following it
+    ~EventLogSpectator() {
+        stop = true;
+        worker.join();
+    }
+
+private:
+    void run() {
+        while (!stop.load(memory_order_relaxed)) {
+            drain();
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        drain();
+        if (subscriber.missed > 0) {
+            file << "missed " << subscriber.missed << " events" << endl;
+        }
+    }
+
+    // Write every event published since the last call
+    void drain() {
+        static const char* const typeNames[] = {"TurnStart", "Move", "Purchase", "Rent", "Tax", "Card", "GoToJail",
+            "LeaveJail", "AuctionWon", "Upgrade", "Mortgage", "Bankrupt", "GameOver", "Salary"};
+        GameEvent event;
+        while (subscriber.poll(event)) {
+            file << event.turn << " " << (event.type <= GameEvent::Salary ? typeNames[event.type] : "Unknown") << " "
+                 << int(event.seat) << " " << int(event.otherSeat) << " " << int(event.position) << " "
+                 << event.amount << " " << event.money << "\n";
+        }
+        file.flush();
+    }
+
+    ofstream file;
+    EventSubscriber subscriber;
+    atomic<bool> stop{false};
+    thread worker;
+};
+
 // Main function to initiate the game
-int main() {
-    srand(time(0)); // Seed for random number generation
+int main(int argc, char* argv[]) {
+    // Command-line tool modes; the interactive game runs when no mode is given
+    string spectatorLogPath; // File the interactive game's events are logged to (--spectator-log <file>)
+    if (argc > 1) {
+        string mode = argv[1];
+        if (mode == "--fuzz") {
+            return runFuzzMode(argc, argv);
+        } else if (mode == "--replay") {
+            return runReplayMode(argc, argv);
+        } else if (mode == "--simulate") {
+            return runSimulateMode(argc, argv);
+        } else if (mode == "--shard-run") {
+            return runShardRunMode(argc, argv);
+        } else if (mode == "--shard-worker") {
+            return runShardWorkerMode(argc, argv);
+        } else if (mode == "--shard-merge") {
+            return runShardMergeMode(argc, argv);
+        } else if (mode == "--cache-bench") {
+            return runCacheBenchMode(argc, argv);
+        } else if (mode == "--env-bench") {
+            return runEnvBenchMode(argc, argv);
+        } else if (mode == "--spectator-bench") {
+            return runSpectatorBenchMode(argc, argv);
+        } else if (mode != "--spectator-log" || argc < 3) {
+            cout << "Unknown mode: " << mode << endl;
+            return 2;
+        }
+        spectatorLogPath = argv[2];
+    }
 
     Board gameBoard;
     int numPlayers;
 
+    // Spectators follow the game through an event ring, so they never slow down or block the players
+    unique_ptr<EventRing> eventRing;
+    unique_ptr<EventLogSpectator> spectator;
+    if (!spectatorLogPath.empty()) {
+        eventRing.reset(new EventRing());
+        gameBoard.eventRing = eventRing.get();
+        spectator.reset(new EventLogSpectator(*eventRing, spectatorLogPath));
+    }
+
     // Welcome message and input number of players
     cout << "Welcome to Monopoly Simplified!" << endl;
     cout << "Enter number of players: ";
@@ -726,6 +2859,7 @@ int main() {
                     gameBoard.tradeProperty(*playerIt);
                 }
             }
+            gameBoard.turnCount++; // Events of the next turn carry the next turn number
         }
 
         // Display the updated board visualization
@@ -739,6 +2873,7 @@ int main() {
 
         // Check if only one player is left
         if (gameBoard.players.size() == 1) {
+            gameBoard.publishEvent(GameEvent::GameOver, gameBoard.players.front(), gameBoard.players.front().position);
             cout << "\n" << gameBoard.players.front().name << " is the last player remaining and wins the game!" << endl;
             break;
         }